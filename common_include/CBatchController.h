@@ -0,0 +1,152 @@
+#pragma once
+
+// 自适应批大小控制器（AIMD，以单批耗时为目标）
+// 每执行完一批由调用者报告该批的行数和耗时：
+//   - 耗时超过目标：批大小乘以 decrease_factor（乘性减小），迅速退出过载
+//   - 耗时未超过目标且该批已凑满：批大小加 increase_step（加性增大），缓慢逼近目标
+//   - 批未凑满（数据已写完或按时间提前发出）时不增大，这样的样本说明不了更大的批次
+// 多个线程可以共用一个控制器并发报告（如 CUserLoader 的多个批次同时在途）。
+// 刷新间隔（第一条数据最多等待多久就发出）跟随单批耗时的指数移动平均，限制在
+// [min_interval, max_interval]：数据库慢时多等一会以摊薄往返，快时尽早发出。
+//
+// 批大小和刷新间隔以原子变量保存，BatchSize()/FlushInterval() 可在任意线程中无锁读取，
+// 便于定期导出到指标日志（见 CQueryMetrics::SetGauge）
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// 控制器配置
+struct BatchControlOptions
+{
+    size_t initial_size = 1000;                        // 初始批大小
+    size_t min_size = 1;                               // 批大小下限
+    size_t max_size = 100000;                          // 批大小上限
+    size_t increase_step = 0;                          // 每次加性增大的行数，0 表示取 initial_size / 10
+    double decrease_factor = 0.5;                      // 超过目标耗时后的缩小倍数
+    std::chrono::microseconds target_latency{100000};  // 单批耗时目标
+    std::chrono::microseconds min_interval{100};       // 刷新间隔下限
+    std::chrono::microseconds max_interval{100000};    // 刷新间隔上限
+};
+
+// 控制器统计
+struct BatchControlStats
+{
+    size_t batch_size = 0;          // 当前批大小
+    double flush_interval_ms = 0.0; // 当前刷新间隔
+    uint64_t batches = 0;           // 已报告的批次数
+    uint64_t increases = 0;         // 增大次数
+    uint64_t decreases = 0;         // 减小次数（含出错）
+    double last_latency_ms = 0.0;   // 最近一批的耗时
+    double avg_latency_ms = 0.0;    // 单批耗时的指数移动平均
+};
+
+class CBatchController
+{
+public:
+    explicit CBatchController(BatchControlOptions options = {})
+        : options_(options)
+    {
+        if (options_.min_size == 0)
+            options_.min_size = 1;
+        options_.max_size = std::max(options_.max_size, options_.min_size);
+        if (options_.increase_step == 0)
+            options_.increase_step = std::max<size_t>(1, options_.initial_size / 10);
+        if (options_.decrease_factor <= 0.0 || options_.decrease_factor >= 1.0)
+            options_.decrease_factor = 0.5;
+        options_.max_interval = std::max(options_.max_interval, options_.min_interval);
+
+        size_ = std::clamp(options_.initial_size, options_.min_size, options_.max_size);
+        interval_us_ = options_.max_interval.count();
+    }
+
+    CBatchController(const CBatchController &) = delete;
+    CBatchController &operator=(const CBatchController &) = delete;
+
+    // 1、当前批大小
+    size_t BatchSize() const { return size_.load(std::memory_order_relaxed); }
+
+    // 2、当前刷新间隔
+    std::chrono::microseconds FlushInterval() const
+    {
+        return std::chrono::microseconds(interval_us_.load(std::memory_order_relaxed));
+    }
+
+    // 3、报告一批的行数和耗时，返回调整后的批大小
+    size_t Observe(size_t rows, std::chrono::steady_clock::duration elapsed)
+    {
+        const double latency_us = std::chrono::duration<double, std::micro>(elapsed).count();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++batches_;
+        last_latency_us_ = latency_us;
+        avg_latency_us_ = batches_ == 1 ? latency_us : avg_latency_us_ * 0.8 + latency_us * 0.2;
+
+        size_t size = size_.load(std::memory_order_relaxed);
+        if (latency_us > static_cast<double>(options_.target_latency.count()))
+        {
+            // 大于当前批大小的批次是在上次减小之前发出的，并发报告时不重复减小
+            if (rows <= size)
+                size = Decrease(size);
+        }
+        else if (rows >= size && size < options_.max_size)
+        {
+            size = std::min(options_.max_size, size + options_.increase_step);
+            ++increases_;
+        }
+        size_.store(size, std::memory_order_relaxed);
+
+        const auto interval = static_cast<int64_t>(avg_latency_us_);
+        interval_us_.store(std::clamp<int64_t>(interval, options_.min_interval.count(), options_.max_interval.count()),
+                           std::memory_order_relaxed);
+        return size;
+    }
+
+    // 4、报告一批执行失败（超时、连接中断等）：按过载处理，乘性减小
+    size_t ObserveError()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++batches_;
+        size_t size = Decrease(size_.load(std::memory_order_relaxed));
+        size_.store(size, std::memory_order_relaxed);
+        return size;
+    }
+
+    BatchControlStats GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        BatchControlStats stats;
+        stats.batch_size = size_.load(std::memory_order_relaxed);
+        stats.flush_interval_ms = interval_us_.load(std::memory_order_relaxed) / 1000.0;
+        stats.batches = batches_;
+        stats.increases = increases_;
+        stats.decreases = decreases_;
+        stats.last_latency_ms = last_latency_us_ / 1000.0;
+        stats.avg_latency_ms = avg_latency_us_ / 1000.0;
+        return stats;
+    }
+
+    const BatchControlOptions &GetOptions() const { return options_; }
+
+private:
+    // 调用者持有 mutex_
+    size_t Decrease(size_t size)
+    {
+        ++decreases_;
+        return std::max(options_.min_size, static_cast<size_t>(static_cast<double>(size) * options_.decrease_factor));
+    }
+
+    BatchControlOptions options_;
+    std::atomic<size_t> size_{1};
+    std::atomic<int64_t> interval_us_{0};
+
+    mutable std::mutex mutex_;
+    uint64_t batches_ = 0;
+    uint64_t increases_ = 0;
+    uint64_t decreases_ = 0;
+    double last_latency_us_ = 0.0;
+    double avg_latency_us_ = 0.0;
+};
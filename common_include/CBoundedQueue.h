@@ -0,0 +1,173 @@
+#pragma once
+
+// 有界阻塞队列（多生产者、多消费者）
+// 队列满时 Push 阻塞，形成背压，生产者速度不会超过消费者；
+// Close 之后 Push 立即失败，Pop 取完剩余元素后返回 std::nullopt。
+// 不能让生产者阻塞的场合可改用 TryPush（丢弃新元素）或 PushOverrun（丢弃最旧的元素）
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// 队列满时的处理方式（与 spdlog::async_overflow_policy 对应）
+enum class OverflowPolicy
+{
+    BLOCK,          // 阻塞等待空位（Push）
+    OVERRUN_OLDEST, // 丢弃队首最旧的元素（PushOverrun）
+    DISCARD_NEW     // 丢弃新元素（TryPush）
+};
+
+template <typename T>
+class CBoundedQueue
+{
+public:
+    explicit CBoundedQueue(size_t capacity) : capacity_(capacity > 0 ? capacity : 1) {}
+
+    CBoundedQueue(const CBoundedQueue &) = delete;
+    CBoundedQueue &operator=(const CBoundedQueue &) = delete;
+
+    // 1、放入元素：队列满时阻塞；队列已关闭时返回 false
+    bool Push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this]
+                       { return closed_ || items_.size() < capacity_; });
+        if (closed_)
+            return false;
+        items_.push_back(std::move(item));
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // 2、非阻塞放入：队列满或已关闭时返回 false
+    bool TryPush(T item)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_ || items_.size() >= capacity_)
+                return false;
+            items_.push_back(std::move(item));
+        }
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // 3、覆盖放入：队列满时丢弃队首最旧的元素，overran 表示是否发生了丢弃；队列已关闭时返回 false
+    bool PushOverrun(T item, bool &overran)
+    {
+        overran = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_)
+                return false;
+            if (items_.size() >= capacity_)
+            {
+                items_.pop_front();
+                overran = true;
+            }
+            items_.push_back(std::move(item));
+        }
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // 4、按 policy 放入，返回是否放入成功（OVERRUN_OLDEST 时 overran 表示是否丢弃了最旧的元素）
+    bool Push(T item, OverflowPolicy policy, bool &overran)
+    {
+        overran = false;
+        switch (policy)
+        {
+        case OverflowPolicy::OVERRUN_OLDEST: return PushOverrun(std::move(item), overran);
+        case OverflowPolicy::DISCARD_NEW: return TryPush(std::move(item));
+        default: return Push(std::move(item));
+        }
+    }
+
+    // 5、取出元素：队列空时阻塞；队列已关闭且为空时返回 std::nullopt
+    std::optional<T> Pop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]
+                        { return closed_ || !items_.empty(); });
+        return TakeLocked(lock);
+    }
+
+    // 6、带截止时间的取出：超时或队列已关闭且为空时返回 std::nullopt
+    std::optional<T> PopUntil(std::chrono::steady_clock::time_point deadline)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait_until(lock, deadline, [this]
+                              { return closed_ || !items_.empty(); });
+        return TakeLocked(lock);
+    }
+
+    // 7、批量取出：等到队列非空（或超时、已关闭）后，一次加锁取出至多 max 个元素追加到 out，
+    //    返回取出的个数
+    size_t PopMany(std::vector<T> &out, size_t max, std::chrono::steady_clock::time_point deadline)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait_until(lock, deadline, [this]
+                              { return closed_ || !items_.empty(); });
+        size_t n = std::min(max, items_.size());
+        for (size_t i = 0; i < n; ++i)
+        {
+            out.push_back(std::move(items_.front()));
+            items_.pop_front();
+        }
+        lock.unlock();
+        if (n > 0)
+            not_full_.notify_all();
+        return n;
+    }
+
+    // 8、关闭队列，唤醒所有等待者
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+    bool Closed() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_;
+    }
+
+    size_t Size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+
+    size_t Capacity() const { return capacity_; }
+
+private:
+    std::optional<T> TakeLocked(std::unique_lock<std::mutex> &lock)
+    {
+        if (items_.empty())
+            return std::nullopt;
+        std::optional<T> item(std::move(items_.front()));
+        items_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return item;
+    }
+
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<T> items_;
+    bool closed_ = false;
+};
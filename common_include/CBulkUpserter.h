@@ -0,0 +1,183 @@
+#pragma once
+
+// 批量合并写入（upsert）
+// 一批行先通过 COPY 写入临时暂存表，再用一条集合式 INSERT ... ON CONFLICT DO UPDATE 合并到目标表，
+// 把逐行 upsert 的 N 次往返变为三条语句：
+//   1、CREATE TEMP TABLE IF NOT EXISTS（每个连接只真正建立一次，提交时自动清空）
+//   2、COPY 暂存表
+//   3、INSERT INTO 目标表 SELECT ... FROM 暂存表 ON CONFLICT (键) DO UPDATE
+// 通过 RETURNING (xmax = 0) 区分新插入与更新的行，并在服务端汇总计数，不把行传回客户端。
+//
+// 注意：
+//   - 目标表必须在 key_columns 上有唯一约束或唯一索引
+//   - 同一批中键重复的行只保留最后添加的一行
+//   - 与现有行内容完全相同的行不会被更新（不产生新的行版本），计入 unchanged
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <pqxx/pqxx>
+
+#include "CBulkWriter.h"
+
+// 单次合并的结果
+struct UpsertResult
+{
+    uint64_t staged = 0;    // 写入暂存表的行数
+    uint64_t inserted = 0;  // 新插入的行数
+    uint64_t updated = 0;   // 更新的行数
+    uint64_t unchanged = 0; // 内容未变化而跳过的行数（含批内重复键）
+    double seconds = 0.0;   // 合并耗时（秒）
+};
+
+template <typename... Cols>
+class CBulkUpserter
+{
+public:
+    using Row = std::tuple<Cols...>;
+
+    // conn: 使用的连接（暂存表属于该连接的会话）；table: 目标表名
+    // columns: 列名，个数须与 Cols 一致；key_columns: 冲突判断使用的键列，须包含在 columns 中
+    // 表名和列名按 SQL 标识符原样拼接，只应传入程序内常量
+    CBulkUpserter(pqxx::connection &conn, std::string table, std::vector<std::string> columns,
+                  std::vector<std::string> key_columns)
+        : conn_(conn), table_(std::move(table)), columns_(std::move(columns)),
+          key_columns_(std::move(key_columns))
+    {
+        if (columns_.size() != sizeof...(Cols))
+        {
+            throw std::invalid_argument("CBulkUpserter: 列名个数与列类型个数不一致");
+        }
+        if (key_columns_.empty())
+        {
+            throw std::invalid_argument("CBulkUpserter: 至少需要一个键列");
+        }
+        for (const auto &key : key_columns_)
+        {
+            if (std::find(columns_.begin(), columns_.end(), key) == columns_.end())
+                throw std::invalid_argument("CBulkUpserter: 键列 " + key + " 不在列名中");
+        }
+
+        // 暂存表名由目标表名派生（去掉模式名前缀）
+        std::string base = table_.substr(table_.find_last_of('.') + 1);
+        stage_ = "bulk_upsert_" + base;
+        BuildSql();
+    }
+
+    CBulkUpserter(const CBulkUpserter &) = delete;
+    CBulkUpserter &operator=(const CBulkUpserter &) = delete;
+
+    // 1、添加一行（按列传值）
+    void Add(const Cols &...values)
+    {
+        bulk_detail::AppendLine(buffer_, values...);
+        ++pending_rows_;
+    }
+
+    // 2、添加一行（tuple）
+    void Add(const Row &row)
+    {
+        std::apply([this](const Cols &...values) { Add(values...); }, row);
+    }
+
+    // 3、添加一个结构体：通过 ADL 查找 ToRow(obj)，返回与 Cols 对应的 tuple
+    template <typename T>
+    void AddObject(const T &obj)
+    {
+        Add(Row(ToRow(obj)));
+    }
+
+    // 4、把已添加的行合并到目标表并提交；失败时抛出异常，已添加的行保留，可重试
+    UpsertResult Merge()
+    {
+        UpsertResult result;
+        if (pending_rows_ == 0)
+            return result;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        pqxx::work tx(conn_);
+        tx.exec(create_sql_);
+        bulk_detail::CopyLines(tx, stage_, bulk_detail::JoinColumns(columns_), buffer_);
+        pqxx::row counts = tx.exec(merge_sql_).one_row();
+        tx.commit();
+
+        result.staged = pending_rows_;
+        result.inserted = counts[0].as<uint64_t>();
+        result.updated = counts[1].as<uint64_t>();
+        result.unchanged = result.staged - result.inserted - result.updated;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        buffer_.clear();
+        pending_rows_ = 0;
+        return result;
+    }
+
+    size_t GetPendingRows() const { return pending_rows_; }
+
+private:
+    bool IsKey(const std::string &column) const
+    {
+        return std::find(key_columns_.begin(), key_columns_.end(), column) != key_columns_.end();
+    }
+
+    void BuildSql()
+    {
+        const std::string column_list = bulk_detail::JoinColumns(columns_);
+        const std::string key_list = bulk_detail::JoinColumns(key_columns_);
+
+        // 只取目标表的列类型，不带约束（未参与合并的 NOT NULL 列不影响 COPY）
+        create_sql_ = "CREATE TEMP TABLE IF NOT EXISTS " + stage_ + " ON COMMIT DELETE ROWS AS SELECT " +
+                      column_list + " FROM " + table_ + " WITH NO DATA";
+
+        // 非键列：冲突时更新，且只在内容确有变化时更新
+        std::vector<std::string> value_columns;
+        for (const auto &column : columns_)
+        {
+            if (!IsKey(column))
+                value_columns.push_back(column);
+        }
+
+        std::string conflict;
+        if (value_columns.empty())
+        {
+            conflict = "DO NOTHING";
+        }
+        else
+        {
+            conflict = "DO UPDATE SET ";
+            for (size_t i = 0; i < value_columns.size(); ++i)
+            {
+                if (i > 0)
+                    conflict += ',';
+                conflict += value_columns[i] + " = EXCLUDED." + value_columns[i];
+            }
+            conflict += " WHERE (" + bulk_detail::JoinColumns(value_columns, "t.") + ") IS DISTINCT FROM (" +
+                        bulk_detail::JoinColumns(value_columns, "EXCLUDED.") + ")";
+        }
+
+        // 批内重复键只保留最后 COPY 的一行（暂存表每次提交后清空，ctid 顺序即写入顺序），
+        // 否则 ON CONFLICT DO UPDATE 会因同一行被更新两次而报错
+        merge_sql_ = "WITH merged AS (INSERT INTO " + table_ + " AS t (" + column_list + ") " +
+                     "SELECT DISTINCT ON (" + key_list + ") " + column_list + " FROM " + stage_ +
+                     " ORDER BY " + key_list + ", ctid DESC " +
+                     "ON CONFLICT (" + key_list + ") " + conflict + " RETURNING (xmax = 0) AS inserted) " +
+                     "SELECT count(*) FILTER (WHERE inserted), count(*) FILTER (WHERE NOT inserted) FROM merged";
+    }
+
+    pqxx::connection &conn_;
+    std::string table_;
+    std::vector<std::string> columns_;
+    std::vector<std::string> key_columns_;
+    std::string stage_;       // 暂存表名
+    std::string create_sql_;  // 建立暂存表
+    std::string merge_sql_;   // 合并语句
+
+    std::string buffer_;      // 待写入的 COPY 文本数据
+    size_t pending_rows_ = 0; // 缓冲区中的行数
+};
@@ -0,0 +1,238 @@
+#pragma once
+
+// 基于 COPY (pqxx::stream_to) 的类型化批量写入器
+// 行数据先按 COPY 文本格式序列化到缓冲区，累计到 flush_rows 行时
+// 在一个事务中通过 COPY 一次性写入，取代拼接多条 INSERT 语句的做法。
+// 设置 CBatchController 后，每次 COPY 的行数和刷新间隔按实际耗时自动调整
+
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <pqxx/pqxx>
+
+#include "CBatchController.h"
+
+// 批量写入统计
+struct BulkStats
+{
+    uint64_t rows = 0;      // 已写入行数
+    uint64_t bytes = 0;     // 已写入的 COPY 数据字节数
+    uint64_t flushes = 0;   // COPY 次数
+    double seconds = 0.0;   // COPY 累计耗时（秒）
+
+    double RowsPerSec() const { return seconds > 0 ? rows / seconds : 0.0; }
+    double BytesPerSec() const { return seconds > 0 ? bytes / seconds : 0.0; }
+};
+
+// COPY 文本格式的序列化工具（CBulkWriter、CBulkUpserter 共用）
+namespace bulk_detail
+{
+    // 转义一个字段：反斜杠、制表符和换行需要转义
+    inline void AppendEscaped(std::string &buffer, std::string_view text)
+    {
+        for (char c : text)
+        {
+            switch (c)
+            {
+            case '\\': buffer.append("\\\\"); break;
+            case '\t': buffer.append("\\t"); break;
+            case '\n': buffer.append("\\n"); break;
+            case '\r': buffer.append("\\r"); break;
+            default: buffer.push_back(c); break;
+            }
+        }
+    }
+
+    // 追加一个字段（制表符分隔，\N 表示 NULL）
+    template <typename T>
+    void AppendField(std::string &buffer, const T &value, bool &first)
+    {
+        if (!first)
+            buffer.push_back('\t');
+        first = false;
+
+        if (pqxx::is_null(value))
+        {
+            buffer.append("\\N");
+            return;
+        }
+        AppendEscaped(buffer, pqxx::to_string(value));
+    }
+
+    // 追加一行
+    template <typename... Cols>
+    void AppendLine(std::string &buffer, const Cols &...values)
+    {
+        bool first = true;
+        (AppendField(buffer, values, first), ...);
+        buffer.push_back('\n');
+    }
+
+    // 通过 COPY 把缓冲区中的全部行写入 table（在 tx 中执行，不提交）
+    inline void CopyLines(pqxx::transaction_base &tx, std::string_view table, std::string_view columns,
+                          std::string_view data)
+    {
+        auto stream = pqxx::stream_to::raw_table(tx, table, columns);
+        while (!data.empty())
+        {
+            size_t eol = data.find('\n');
+            stream.write_raw_line(data.substr(0, eol));
+            data.remove_prefix(eol + 1);
+        }
+        stream.complete();
+    }
+
+    // 拼接逗号分隔的标识符列表（按原样拼接，只应传入程序内常量）
+    inline std::string JoinColumns(const std::vector<std::string> &columns, std::string_view prefix = {})
+    {
+        std::string list;
+        for (const auto &column : columns)
+        {
+            if (!list.empty())
+                list.push_back(',');
+            list += prefix;
+            list += column;
+        }
+        return list;
+    }
+} // namespace bulk_detail
+
+template <typename... Cols>
+class CBulkWriter
+{
+public:
+    using Row = std::tuple<Cols...>;
+
+    // conn: 写入使用的连接；table: 表名；columns: 列名，个数须与 Cols 一致
+    //       表名和列名按 SQL 标识符原样拼接（与 COMPANY_1、ID 等写法一致），只应传入程序内常量
+    // flush_rows: 缓冲多少行后执行一次 COPY（每次 COPY 在独立事务中提交）
+    CBulkWriter(pqxx::connection &conn, std::string table,
+                std::vector<std::string> columns, size_t flush_rows = 10000)
+        : conn_(conn), table_(std::move(table)), columns_(std::move(columns)),
+          flush_rows_(flush_rows > 0 ? flush_rows : 1)
+    {
+        if (columns_.size() != sizeof...(Cols))
+        {
+            throw std::invalid_argument("CBulkWriter: 列名个数与列类型个数不一致");
+        }
+    }
+
+    // 析构时不自动提交：未 Flush 的数据被丢弃，避免在析构函数中抛出异常
+    ~CBulkWriter() = default;
+
+    CBulkWriter(const CBulkWriter &) = delete;
+    CBulkWriter &operator=(const CBulkWriter &) = delete;
+
+    // 1、添加一行（按列传值）
+    void Add(const Cols &...values)
+    {
+        AppendLine(values...);
+    }
+
+    // 2、添加一行（tuple）
+    void Add(const Row &row)
+    {
+        std::apply([this](const Cols &...values) { AppendLine(values...); }, row);
+    }
+
+    // 3、添加一个结构体：通过 ADL 查找 ToRow(obj)，返回与 Cols 对应的 tuple
+    template <typename T>
+    void AddObject(const T &obj)
+    {
+        Add(Row(ToRow(obj)));
+    }
+
+    // 4、把缓冲区中的数据通过 COPY 写入数据库并提交
+    void Flush()
+    {
+        if (pending_rows_ == 0)
+            return;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        try
+        {
+            pqxx::work tx(conn_);
+            bulk_detail::CopyLines(tx, table_, bulk_detail::JoinColumns(columns_), buffer_);
+            tx.commit();
+        }
+        catch (...)
+        {
+            if (controller_)
+                flush_rows_ = controller_->ObserveError();
+            throw;
+        }
+
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        stats_.seconds += std::chrono::duration<double>(elapsed).count();
+        if (controller_)
+        {
+            flush_rows_ = controller_->Observe(pending_rows_, elapsed);
+            flush_interval_ = controller_->FlushInterval();
+        }
+        stats_.rows += pending_rows_;
+        stats_.bytes += buffer_.size();
+        ++stats_.flushes;
+
+        buffer_.clear();
+        pending_rows_ = 0;
+    }
+
+    // 5、调整每次 COPY 的行数
+    void SetFlushRows(size_t flush_rows) { flush_rows_ = flush_rows > 0 ? flush_rows : 1; }
+    size_t GetFlushRows() const { return flush_rows_; }
+
+    // 6、按时间刷新：缓冲区中最早的一行等待超过 interval 后，下一次 Add 时执行 COPY（0 表示只按行数）
+    void SetFlushInterval(std::chrono::microseconds interval) { flush_interval_ = interval; }
+
+    // 7、由控制器调整行数和刷新间隔（控制器须比写入器存活更久，传 nullptr 取消）
+    void SetController(CBatchController *controller)
+    {
+        controller_ = controller;
+        if (controller_)
+        {
+            flush_rows_ = controller_->BatchSize();
+            flush_interval_ = controller_->FlushInterval();
+        }
+    }
+
+    size_t GetPendingRows() const { return pending_rows_; }
+    const BulkStats &GetStats() const { return stats_; }
+
+private:
+    // 序列化一行到缓冲区（COPY 文本格式：制表符分隔，\N 表示 NULL）
+    void AppendLine(const Cols &...values)
+    {
+        bulk_detail::AppendLine(buffer_, values...);
+
+        if (++pending_rows_ >= flush_rows_)
+        {
+            Flush();
+        }
+        else if (flush_interval_.count() > 0)
+        {
+            const auto now = std::chrono::steady_clock::now();
+            if (pending_rows_ == 1)
+                first_pending_ = now;
+            else if (now - first_pending_ >= flush_interval_)
+                Flush();
+        }
+    }
+
+    pqxx::connection &conn_;
+    std::string table_;
+    std::vector<std::string> columns_;
+    size_t flush_rows_;
+    std::chrono::microseconds flush_interval_{0};
+    CBatchController *controller_ = nullptr;
+
+    std::string buffer_;        // 待写入的 COPY 文本数据
+    size_t pending_rows_ = 0;   // 缓冲区中的行数
+    std::chrono::steady_clock::time_point first_pending_; // 缓冲区中最早一行的加入时间
+    BulkStats stats_;
+};
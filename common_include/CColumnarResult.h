@@ -0,0 +1,162 @@
+#pragma once
+
+// 把 pqxx::result 转换为按列存储（SoA）的类型化数组
+// 整数/浮点列存为连续的 int32/int64/double 数组，字符串列存放在同一块 arena 中，
+// 每列附带 NULL 位图，便于报表类统计做缓存友好、可向量化的循环
+//
+// 列类型按 result 中的类型 OID 决定：
+//   bool/int2/int4 -> Int32, int8 -> Int64, float4/float8/numeric -> Double, 其余 -> String
+// numeric 转换为 double 会损失精度，只适用于统计场景
+// NULL 值在数值数组中为 0，在字符串列中为空串，需结合 IsNull 判断
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <pqxx/pqxx>
+
+enum class ColumnKind
+{
+    Int32,
+    Int64,
+    Double,
+    String
+};
+
+// 一列数据
+struct ColumnData
+{
+    std::string name;
+    pqxx::oid type_oid = 0;
+    ColumnKind kind = ColumnKind::String;
+
+    std::vector<int32_t> i32;       // kind == Int32
+    std::vector<int64_t> i64;       // kind == Int64
+    std::vector<double> f64;        // kind == Double
+    std::string arena;              // kind == String：所有字符串首尾相接
+    std::vector<uint32_t> offsets;  // kind == String：第 i 行为 arena[offsets[i], offsets[i+1])
+
+    std::vector<uint64_t> null_bits; // NULL 位图，第 i 位为 1 表示第 i 行为 NULL
+    size_t null_count = 0;
+
+    bool IsNull(size_t row) const { return (null_bits[row >> 6] >> (row & 63)) & 1; }
+
+    std::string_view GetString(size_t row) const
+    {
+        return std::string_view(arena).substr(offsets[row], offsets[row + 1] - offsets[row]);
+    }
+};
+
+class CColumnarResult
+{
+public:
+    explicit CColumnarResult(const pqxx::result &result)
+    {
+        rows_ = static_cast<size_t>(result.size());
+        const int column_count = result.columns();
+        columns_.resize(column_count);
+
+        // 1、按类型 OID 确定每列的存储方式并预分配空间
+        for (int c = 0; c < column_count; ++c)
+        {
+            ColumnData &column = columns_[c];
+            column.name = result.column_name(c);
+            column.type_oid = result.column_type(c);
+            column.kind = KindOf(column.type_oid);
+            column.null_bits.assign((rows_ + 63) / 64, 0);
+            switch (column.kind)
+            {
+            case ColumnKind::Int32: column.i32.resize(rows_); break;
+            case ColumnKind::Int64: column.i64.resize(rows_); break;
+            case ColumnKind::Double: column.f64.resize(rows_); break;
+            case ColumnKind::String:
+                column.offsets.resize(rows_ + 1);
+                column.offsets[0] = 0;
+                break;
+            }
+        }
+
+        // 2、逐行读取一次，把每个字段写入对应列
+        size_t r = 0;
+        for (const auto &row : result)
+        {
+            for (int c = 0; c < column_count; ++c)
+            {
+                Store(columns_[c], r, row[c]);
+            }
+            ++r;
+        }
+    }
+
+    size_t Rows() const { return rows_; }
+    size_t Columns() const { return columns_.size(); }
+
+    const ColumnData &operator[](size_t c) const { return columns_[c]; }
+
+    // 按列名查找（区分大小写，与 result 中的列名一致），不存在时抛出 std::out_of_range
+    const ColumnData &Get(std::string_view name) const
+    {
+        for (const auto &column : columns_)
+        {
+            if (column.name == name)
+                return column;
+        }
+        throw std::out_of_range("CColumnarResult: 不存在的列 " + std::string(name));
+    }
+
+private:
+    static ColumnKind KindOf(pqxx::oid type_oid)
+    {
+        switch (type_oid)
+        {
+        case 16:   // bool
+        case 21:   // int2
+        case 23:   // int4
+            return ColumnKind::Int32;
+        case 20:   // int8
+            return ColumnKind::Int64;
+        case 700:  // float4
+        case 701:  // float8
+        case 1700: // numeric
+            return ColumnKind::Double;
+        default:
+            return ColumnKind::String;
+        }
+    }
+
+    static void Store(ColumnData &column, size_t r, const pqxx::field &field)
+    {
+        const bool is_null = field.is_null();
+        if (is_null)
+        {
+            column.null_bits[r >> 6] |= uint64_t(1) << (r & 63);
+            ++column.null_count;
+        }
+
+        switch (column.kind)
+        {
+        case ColumnKind::Int32:
+            if (column.type_oid == 16)
+                column.i32[r] = is_null ? 0 : (field.view() == "t" ? 1 : 0);
+            else
+                column.i32[r] = is_null ? 0 : field.as<int32_t>();
+            break;
+        case ColumnKind::Int64:
+            column.i64[r] = is_null ? 0 : field.as<int64_t>();
+            break;
+        case ColumnKind::Double:
+            column.f64[r] = is_null ? 0.0 : field.as<double>();
+            break;
+        case ColumnKind::String:
+            if (!is_null)
+                column.arena.append(field.view());
+            column.offsets[r + 1] = static_cast<uint32_t>(column.arena.size());
+            break;
+        }
+    }
+
+    size_t rows_ = 0;
+    std::vector<ColumnData> columns_;
+};
@@ -88,6 +88,11 @@ public:
         }
         return default_value;
     }
+    // 获取原始节点（用于列表、嵌套映射等复合配置项，不存在时返回空节点）
+    YAML::Node GetNode(const std::string &itemname)
+    {
+        return config[itemname];
+    }
 
     // 5、防止拷贝
     CConfig(const CConfig &) = delete;
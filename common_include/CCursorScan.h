@@ -0,0 +1,65 @@
+#pragma once
+
+// 基于服务端游标（DECLARE ... NO SCROLL CURSOR + FETCH）的分块扫描
+// 每次只取 fetch_size 行交给回调处理，处理完即释放，客户端内存与结果集大小无关；
+// 只向前读取，取回的块不足 fetch_size 行（或为空）即结束，不需要事先知道结果集大小；
+// 开启预取时，在回调处理当前块的同时于后台线程取下一块，使处理与网络传输重叠
+//
+// 注意：
+//   - tx 必须是真正的事务（pqxx::work / pqxx::read_transaction），游标只在事务内有效
+//   - 开启预取时回调中不得再使用 tx 或其所属连接
+
+#include <cstddef>
+#include <future>
+#include <string>
+#include <pqxx/pqxx>
+
+// 扫描 query 的结果，每块调用一次 fn(const pqxx::result &chunk)，返回总行数
+template <typename Fn>
+size_t CursorScan(pqxx::transaction_base &tx, const std::string &query, size_t fetch_size, Fn &&fn,
+                  bool prefetch = false, const std::string &cursor_name = "cursor_scan")
+{
+    if (fetch_size == 0)
+        fetch_size = 1;
+
+    // stateless_cursor 第一次 retrieve 会用 MOVE ALL 求结果集大小，相当于把整个查询先执行一遍，
+    // 这里直接声明只向前的游标，逐块 FETCH
+    const std::string name = tx.quote_name(cursor_name);
+    tx.exec("DECLARE " + name + " NO SCROLL CURSOR FOR " + query);
+
+    const auto step = static_cast<pqxx::result::size_type>(fetch_size);
+    const std::string fetch_sql = "FETCH FORWARD " + std::to_string(fetch_size) + " FROM " + name;
+    auto fetch = [&tx, &fetch_sql]
+    { return tx.exec(fetch_sql); };
+
+    size_t total = 0;
+    pqxx::result chunk = fetch();
+    while (!chunk.empty())
+    {
+        const bool last = chunk.size() < step;
+
+        // 预取：下一块在后台取回，同时处理当前块
+        std::future<pqxx::result> next;
+        if (prefetch && !last)
+        {
+            next = std::async(std::launch::async, fetch);
+        }
+
+        fn(chunk);
+        total += static_cast<size_t>(chunk.size());
+
+        if (last)
+            break;
+        if (next.valid())
+        {
+            chunk = next.get();
+        }
+        else
+        {
+            chunk.clear(); // 先释放当前块再取下一块
+            chunk = fetch();
+        }
+    }
+    tx.exec("CLOSE " + name);
+    return total;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+// HDR 风格的无锁延迟直方图
+// 桶按对数-线性划分：每个 2 的幂区间再细分为 16 个子桶，相对误差不超过约 6%，
+// 覆盖 0 ~ 2^64 的全部取值，桶数固定（976 个），记录一次只是一次原子自增，可在生产环境常开。
+// 取值单位由调用者决定（通常为微秒）
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class CLatencyHistogram
+{
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;                   // 每个 2 的幂区间 16 个子桶
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;    // 16
+    static constexpr int LINEAR_BUCKETS = SUB_BUCKETS * 2;      // 0 ~ 31 每个值一个桶
+    static constexpr int BUCKET_COUNT = LINEAR_BUCKETS + (64 - SUB_BUCKET_BITS - 1) * SUB_BUCKETS;
+
+    // 某一时刻的计数快照，用于计算分位数
+    struct Snapshot
+    {
+        std::vector<uint64_t> counts;
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+
+        double Mean() const { return count ? double(sum) / double(count) : 0.0; }
+
+        // q 取 0 ~ 1，返回所在桶的中点（不超过观测到的最大值）
+        uint64_t Percentile(double q) const
+        {
+            if (count == 0)
+                return 0;
+            uint64_t rank = static_cast<uint64_t>(q * double(count));
+            if (rank >= count)
+                rank = count - 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < counts.size(); ++i)
+            {
+                seen += counts[i];
+                if (seen > rank)
+                {
+                    uint64_t mid = BucketLower(static_cast<int>(i)) + BucketWidth(static_cast<int>(i)) / 2;
+                    return mid < max ? mid : max;
+                }
+            }
+            return max;
+        }
+    };
+
+    // 1、记录一个取值
+    void Record(uint64_t value)
+    {
+        buckets_[Index(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        uint64_t prev = max_.load(std::memory_order_relaxed);
+        while (value > prev && !max_.compare_exchange_weak(prev, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // 2、获取快照；reset 为 true 时同时清零（用于按时间窗口统计）
+    Snapshot Take(bool reset = false)
+    {
+        Snapshot snapshot;
+        snapshot.counts.resize(BUCKET_COUNT);
+        for (int i = 0; i < BUCKET_COUNT; ++i)
+        {
+            snapshot.counts[i] = reset ? buckets_[i].exchange(0, std::memory_order_relaxed)
+                                       : buckets_[i].load(std::memory_order_relaxed);
+            snapshot.count += snapshot.counts[i];
+        }
+        // 以桶计数之和为准，避免与并发 Record 之间的微小不一致
+        snapshot.sum = reset ? sum_.exchange(0, std::memory_order_relaxed) : sum_.load(std::memory_order_relaxed);
+        snapshot.max = reset ? max_.exchange(0, std::memory_order_relaxed) : max_.load(std::memory_order_relaxed);
+        if (reset)
+            count_.exchange(0, std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+
+    // 3、取值与桶之间的映射
+    static int Index(uint64_t value)
+    {
+        if (value < static_cast<uint64_t>(LINEAR_BUCKETS))
+            return static_cast<int>(value);
+        int bits = 64 - __builtin_clzll(value);  // 有效位数，>= 6
+        int shift = bits - SUB_BUCKET_BITS - 1;   // 使 value >> shift 落在 [16, 32)
+        return LINEAR_BUCKETS + (shift - 1) * SUB_BUCKETS +
+               static_cast<int>((value >> shift) - SUB_BUCKETS);
+    }
+
+    static uint64_t BucketLower(int index)
+    {
+        if (index < LINEAR_BUCKETS)
+            return static_cast<uint64_t>(index);
+        int shift = (index - LINEAR_BUCKETS) / SUB_BUCKETS + 1;
+        uint64_t sub = static_cast<uint64_t>((index - LINEAR_BUCKETS) % SUB_BUCKETS + SUB_BUCKETS);
+        return sub << shift;
+    }
+
+    static uint64_t BucketWidth(int index)
+    {
+        if (index < LINEAR_BUCKETS)
+            return 1;
+        return uint64_t(1) << ((index - LINEAR_BUCKETS) / SUB_BUCKETS + 1);
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+// 可复用的查询参数缓冲区
+// 整数和浮点数用 std::to_chars 直接转换到同一块缓冲区，各数组在调用之间保留容量，
+// 稳定状态下构造参数不再分配内存。
+//   - libpq 路径：CPgConn::ExecPrepared(name, arena) 直接使用 Values()/Lengths()，参数部分零分配
+//   - libpqxx 路径：BuildParams() 生成引用缓冲区内容的 pqxx::params（zview，不复制参数文本）
+//
+// 每个线程通过 ThreadLocal() 使用自己的实例；一次查询开始前调用 Reset()，
+// 查询完成前不得再次 Reset（Values() 和 BuildParams() 返回的指针指向内部缓冲区）
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include <pqxx/pqxx>
+
+class CParamArena
+{
+public:
+    // 1、获取当前线程的实例
+    static CParamArena &ThreadLocal()
+    {
+        thread_local CParamArena arena;
+        return arena;
+    }
+
+    // 2、清空参数，保留已分配的容量
+    CParamArena &Reset()
+    {
+        buffer_.clear();
+        offsets_.clear();
+        lengths_.clear();
+        return *this;
+    }
+
+    // 3、追加参数
+    CParamArena &Add(int32_t value) { return AddNumber(value); }
+    CParamArena &Add(int64_t value) { return AddNumber(value); }
+    CParamArena &Add(uint32_t value) { return AddNumber(value); }
+    CParamArena &Add(uint64_t value) { return AddNumber(value); }
+    CParamArena &Add(float value) { return AddNumber(value); }
+    CParamArena &Add(double value) { return AddNumber(value); }
+    CParamArena &Add(bool value) { return Add(std::string_view(value ? "t" : "f")); }
+    CParamArena &Add(const char *value) { return value ? Add(std::string_view(value)) : AddNull(); }
+    CParamArena &Add(std::nullptr_t) { return AddNull(); }
+
+    CParamArena &Add(std::string_view value)
+    {
+        size_t pos = buffer_.size();
+        buffer_.insert(buffer_.end(), value.begin(), value.end());
+        return Finish(pos);
+    }
+
+    CParamArena &AddNull()
+    {
+        offsets_.push_back(NULL_OFFSET);
+        lengths_.push_back(0);
+        return *this;
+    }
+
+    // 追加一个数组参数，格式为 PostgreSQL 数组字面量 {1,2,3}（仅限数值元素）
+    template <typename T>
+    CParamArena &AddArray(const std::vector<T> &values)
+    {
+        size_t pos = buffer_.size();
+        buffer_.push_back('{');
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            if (i > 0)
+                buffer_.push_back(',');
+            AppendNumber(values[i]);
+        }
+        buffer_.push_back('}');
+        return Finish(pos);
+    }
+
+    // 4、读取参数
+    int Size() const { return static_cast<int>(offsets_.size()); }
+
+    // 参数值指针数组（NULL 参数为 nullptr），在下一次 Add/Reset 之前有效
+    const char *const *Values()
+    {
+        values_.resize(offsets_.size());
+        for (size_t i = 0; i < offsets_.size(); ++i)
+        {
+            values_[i] = offsets_[i] == NULL_OFFSET ? nullptr : buffer_.data() + offsets_[i];
+        }
+        return values_.data();
+    }
+
+    const int *Lengths() const { return lengths_.data(); }
+
+    // 生成引用缓冲区内容的 pqxx::params，使用期间不得修改本实例
+    pqxx::params BuildParams()
+    {
+        pqxx::params params;
+        params.reserve(offsets_.size());
+        for (size_t i = 0; i < offsets_.size(); ++i)
+        {
+            if (offsets_[i] == NULL_OFFSET)
+                params.append();
+            else
+                params.append(pqxx::zview(buffer_.data() + offsets_[i], static_cast<size_t>(lengths_[i])));
+        }
+        return params;
+    }
+
+private:
+    static constexpr size_t NULL_OFFSET = static_cast<size_t>(-1);
+    static constexpr size_t MAX_NUMBER_CHARS = 32; // 足以容纳 int64 和 double 的最短表示
+
+    template <typename T>
+    CParamArena &AddNumber(T value)
+    {
+        size_t pos = buffer_.size();
+        AppendNumber(value);
+        return Finish(pos);
+    }
+
+    template <typename T>
+    void AppendNumber(T value)
+    {
+        size_t pos = buffer_.size();
+        buffer_.resize(pos + MAX_NUMBER_CHARS);
+        auto result = std::to_chars(buffer_.data() + pos, buffer_.data() + buffer_.size(), value);
+        buffer_.resize(static_cast<size_t>(result.ptr - buffer_.data()));
+    }
+
+    // 记录从 pos 开始的参数并追加结尾的 '\0'（libpq 文本参数要求以 '\0' 结尾）
+    CParamArena &Finish(size_t pos)
+    {
+        offsets_.push_back(pos);
+        lengths_.push_back(static_cast<int>(buffer_.size() - pos));
+        buffer_.push_back('\0');
+        return *this;
+    }
+
+    std::vector<char> buffer_;        // 所有参数文本首尾相接，各自以 '\0' 结尾
+    std::vector<size_t> offsets_;     // 每个参数在 buffer_ 中的起始位置
+    std::vector<int> lengths_;        // 每个参数的长度（不含 '\0'）
+    std::vector<const char *> values_; // Values() 的输出
+};
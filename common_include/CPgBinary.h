@@ -0,0 +1,181 @@
+#pragma once
+
+// PostgreSQL 二进制传输格式解码
+// 直接从网络字节序（大端）读取 int2/int4/int8/float4/float8/numeric/timestamp，
+// 省去服务端格式化为文本、客户端再解析文本的开销
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace pgbinary
+{
+    // 常用类型 OID
+    constexpr unsigned int BOOLOID = 16;
+    constexpr unsigned int INT8OID = 20;
+    constexpr unsigned int INT2OID = 21;
+    constexpr unsigned int INT4OID = 23;
+    constexpr unsigned int FLOAT4OID = 700;
+    constexpr unsigned int FLOAT8OID = 701;
+    constexpr unsigned int TIMESTAMPOID = 1114;
+    constexpr unsigned int TIMESTAMPTZOID = 1184;
+    constexpr unsigned int NUMERICOID = 1700;
+
+    // PostgreSQL 纪元（2000-01-01）与 Unix 纪元之间相差的微秒数
+    constexpr int64_t POSTGRES_EPOCH_UNIX_MICROS = 946684800LL * 1000000LL;
+
+    inline uint16_t ReadU16(const char *p)
+    {
+        const auto *b = reinterpret_cast<const unsigned char *>(p);
+        return static_cast<uint16_t>((b[0] << 8) | b[1]);
+    }
+
+    inline uint32_t ReadU32(const char *p)
+    {
+        const auto *b = reinterpret_cast<const unsigned char *>(p);
+        return (uint32_t(b[0]) << 24) | (uint32_t(b[1]) << 16) | (uint32_t(b[2]) << 8) | uint32_t(b[3]);
+    }
+
+    inline uint64_t ReadU64(const char *p)
+    {
+        return (uint64_t(ReadU32(p)) << 32) | ReadU32(p + 4);
+    }
+
+    inline bool ReadBool(const char *p) { return *p != 0; }
+    inline int16_t ReadInt16(const char *p) { return static_cast<int16_t>(ReadU16(p)); }
+    inline int32_t ReadInt32(const char *p) { return static_cast<int32_t>(ReadU32(p)); }
+    inline int64_t ReadInt64(const char *p) { return static_cast<int64_t>(ReadU64(p)); }
+
+    inline float ReadFloat4(const char *p)
+    {
+        uint32_t bits = ReadU32(p);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    inline double ReadFloat8(const char *p)
+    {
+        uint64_t bits = ReadU64(p);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // timestamp/timestamptz：自 2000-01-01 起的微秒数，转换为 Unix 纪元微秒
+    // ±infinity 分别映射为 int64 的最大/最小值
+    inline int64_t ReadTimestampUnixMicros(const char *p)
+    {
+        int64_t pg_micros = ReadInt64(p);
+        if (pg_micros == std::numeric_limits<int64_t>::max() ||
+            pg_micros == std::numeric_limits<int64_t>::min())
+        {
+            return pg_micros;
+        }
+        return pg_micros + POSTGRES_EPOCH_UNIX_MICROS;
+    }
+
+    // numeric 二进制格式：ndigits, weight, sign, dscale（均为 int16），随后是 ndigits 个 base-10000 数字
+    struct NumericHeader
+    {
+        int16_t ndigits;
+        int16_t weight;
+        uint16_t sign;
+        int16_t dscale;
+    };
+
+    constexpr uint16_t NUMERIC_POS = 0x0000;
+    constexpr uint16_t NUMERIC_NEG = 0x4000;
+    constexpr uint16_t NUMERIC_NAN = 0xC000;
+    constexpr uint16_t NUMERIC_PINF = 0xD000;
+    constexpr uint16_t NUMERIC_NINF = 0xF000;
+
+    inline NumericHeader ReadNumericHeader(const char *p, int len)
+    {
+        if (len < 8)
+            throw std::runtime_error("numeric 二进制数据长度不足");
+        NumericHeader h{ReadInt16(p), ReadInt16(p + 2), ReadU16(p + 4), ReadInt16(p + 6)};
+        if (h.ndigits < 0 || len < 8 + 2 * h.ndigits)
+            throw std::runtime_error("numeric 二进制数据长度不足");
+        return h;
+    }
+
+    // numeric -> double（可能损失精度，适用于统计计算）
+    inline double ReadNumericAsDouble(const char *p, int len)
+    {
+        NumericHeader h = ReadNumericHeader(p, len);
+        switch (h.sign)
+        {
+        case NUMERIC_NAN: return std::numeric_limits<double>::quiet_NaN();
+        case NUMERIC_PINF: return std::numeric_limits<double>::infinity();
+        case NUMERIC_NINF: return -std::numeric_limits<double>::infinity();
+        default: break;
+        }
+
+        double value = 0.0;
+        for (int i = 0; i < h.ndigits; ++i)
+        {
+            value = value * 10000.0 + ReadInt16(p + 8 + 2 * i);
+        }
+        // value 目前以最后一位数字为个位，按 weight 调整指数
+        int exponent = h.weight - (h.ndigits - 1);
+        double scale = 1.0;
+        for (int i = 0; i < (exponent < 0 ? -exponent : exponent); ++i)
+            scale *= 10000.0;
+        value = exponent < 0 ? value / scale : value * scale;
+        return h.sign == NUMERIC_NEG ? -value : value;
+    }
+
+    // numeric -> 十进制字符串（精确，保留 dscale 位小数）
+    inline std::string ReadNumericAsString(const char *p, int len)
+    {
+        NumericHeader h = ReadNumericHeader(p, len);
+        switch (h.sign)
+        {
+        case NUMERIC_NAN: return "NaN";
+        case NUMERIC_PINF: return "Infinity";
+        case NUMERIC_NINF: return "-Infinity";
+        default: break;
+        }
+
+        auto digit = [&](int i) -> int
+        { return (i >= 0 && i < h.ndigits) ? ReadInt16(p + 8 + 2 * i) : 0; };
+
+        std::string out;
+        if (h.sign == NUMERIC_NEG)
+            out.push_back('-');
+
+        // 整数部分：第 0..weight 个 base-10000 数字
+        if (h.weight < 0)
+        {
+            out.push_back('0');
+        }
+        else
+        {
+            for (int i = 0; i <= h.weight; ++i)
+            {
+                std::string group = std::to_string(digit(i));
+                if (i > 0)
+                    group.insert(0, 4 - group.size(), '0');
+                out += group;
+            }
+        }
+
+        // 小数部分：从第 weight+1 个数字开始，截取 dscale 位
+        if (h.dscale > 0)
+        {
+            out.push_back('.');
+            std::string frac;
+            for (int i = h.weight + 1; static_cast<int>(frac.size()) < h.dscale; ++i)
+            {
+                std::string group = std::to_string(digit(i));
+                group.insert(0, 4 - group.size(), '0');
+                frac += group;
+            }
+            out.append(frac, 0, h.dscale);
+        }
+        return out;
+    }
+}
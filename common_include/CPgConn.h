@@ -0,0 +1,179 @@
+#pragma once
+
+// libpq 连接与结果的 RAII 封装
+// 用于 libpqxx 未提供的底层能力，例如以二进制格式接收结果：
+// 服务端不再把数值格式化为文本，客户端也不必再解析文本
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <libpq-fe.h>
+
+#include "CPgBinary.h"
+#include "CParamArena.h"
+
+// 查询结果，析构时自动 PQclear
+class CPgResult
+{
+public:
+    CPgResult() = default;
+    explicit CPgResult(PGresult *res) : res_(res, &PQclear) {}
+
+    PGresult *Raw() const { return res_.get(); }
+    explicit operator bool() const { return res_ != nullptr; }
+
+    int Rows() const { return PQntuples(res_.get()); }
+    int Columns() const { return PQnfields(res_.get()); }
+    int ColumnNumber(const char *name) const { return PQfnumber(res_.get(), name); }
+    Oid ColumnType(int col) const { return PQftype(res_.get(), col); }
+    bool IsBinary(int col) const { return PQfformat(res_.get(), col) == 1; }
+
+    bool IsNull(int row, int col) const { return PQgetisnull(res_.get(), row, col) == 1; }
+    const char *Value(int row, int col) const { return PQgetvalue(res_.get(), row, col); }
+    int Length(int row, int col) const { return PQgetlength(res_.get(), row, col); }
+
+    // 以下读取函数要求结果为二进制格式，按列的类型 OID 解码
+
+    // int2/int4/int8 -> int64
+    int64_t GetInt64(int row, int col) const
+    {
+        const char *p = Value(row, col);
+        switch (ColumnType(col))
+        {
+        case pgbinary::INT2OID: return pgbinary::ReadInt16(p);
+        case pgbinary::INT4OID: return pgbinary::ReadInt32(p);
+        case pgbinary::INT8OID: return pgbinary::ReadInt64(p);
+        case pgbinary::BOOLOID: return pgbinary::ReadBool(p) ? 1 : 0;
+        default: throw std::runtime_error(TypeError(col, "整数"));
+        }
+    }
+
+    int32_t GetInt32(int row, int col) const { return static_cast<int32_t>(GetInt64(row, col)); }
+
+    // float4/float8/numeric/整数 -> double
+    double GetDouble(int row, int col) const
+    {
+        const char *p = Value(row, col);
+        switch (ColumnType(col))
+        {
+        case pgbinary::FLOAT4OID: return pgbinary::ReadFloat4(p);
+        case pgbinary::FLOAT8OID: return pgbinary::ReadFloat8(p);
+        case pgbinary::NUMERICOID: return pgbinary::ReadNumericAsDouble(p, Length(row, col));
+        case pgbinary::INT2OID:
+        case pgbinary::INT4OID:
+        case pgbinary::INT8OID: return static_cast<double>(GetInt64(row, col));
+        default: throw std::runtime_error(TypeError(col, "浮点数"));
+        }
+    }
+
+    // numeric -> 精确的十进制字符串
+    std::string GetNumericString(int row, int col) const
+    {
+        if (ColumnType(col) != pgbinary::NUMERICOID)
+            throw std::runtime_error(TypeError(col, "numeric"));
+        return pgbinary::ReadNumericAsString(Value(row, col), Length(row, col));
+    }
+
+    // timestamp/timestamptz -> Unix 纪元微秒
+    int64_t GetTimestampMicros(int row, int col) const
+    {
+        Oid type = ColumnType(col);
+        if (type != pgbinary::TIMESTAMPOID && type != pgbinary::TIMESTAMPTZOID)
+            throw std::runtime_error(TypeError(col, "timestamp"));
+        return pgbinary::ReadTimestampUnixMicros(Value(row, col));
+    }
+
+    // 文本/二进制通用：text、varchar 等类型在两种格式下内容相同
+    std::string_view GetStringView(int row, int col) const
+    {
+        return std::string_view(Value(row, col), static_cast<size_t>(Length(row, col)));
+    }
+
+private:
+    std::string TypeError(int col, const char *expected) const
+    {
+        return std::string("列 ") + PQfname(res_.get(), col) + " (OID " +
+               std::to_string(ColumnType(col)) + ") 不能按" + expected + "读取";
+    }
+
+    std::shared_ptr<PGresult> res_;
+};
+
+// 数据库连接，析构时自动 PQfinish
+class CPgConn
+{
+public:
+    enum ResultFormat
+    {
+        TEXT = 0,
+        BINARY = 1
+    };
+
+    // 建立连接，失败时抛出 std::runtime_error
+    explicit CPgConn(const std::string &conn_str) : conn_(PQconnectdb(conn_str.c_str()), &PQfinish)
+    {
+        if (!conn_ || PQstatus(conn_.get()) != CONNECTION_OK)
+        {
+            throw std::runtime_error(std::string("数据库连接失败: ") +
+                                     (conn_ ? PQerrorMessage(conn_.get()) : "内存不足"));
+        }
+    }
+
+    PGconn *Raw() const { return conn_.get(); }
+    bool IsOpen() const { return PQstatus(conn_.get()) == CONNECTION_OK; }
+
+    // 准备语句（参数类型由服务端推断）
+    void Prepare(const std::string &name, const std::string &sql)
+    {
+        Check(PQprepare(conn_.get(), name.c_str(), sql.c_str(), 0, nullptr), sql);
+    }
+
+    // 执行参数化查询；values 为文本格式参数，nullptr 表示 NULL
+    CPgResult Exec(const std::string &sql, const std::vector<const char *> &values = {},
+                   ResultFormat format = TEXT)
+    {
+        return Check(PQexecParams(conn_.get(), sql.c_str(), static_cast<int>(values.size()), nullptr,
+                                  values.data(), nullptr, nullptr, format),
+                     sql);
+    }
+
+    // 执行已准备的语句；lengths/formats 可为 nullptr（表示全部为文本参数）
+    CPgResult ExecPrepared(const std::string &name, int n_params, const char *const *values,
+                           const int *lengths = nullptr, const int *formats = nullptr,
+                           ResultFormat format = TEXT)
+    {
+        return Check(PQexecPrepared(conn_.get(), name.c_str(), n_params, values, lengths, formats, format),
+                     name);
+    }
+
+    CPgResult ExecPrepared(const std::string &name, const std::vector<const char *> &values,
+                           ResultFormat format = TEXT)
+    {
+        return ExecPrepared(name, static_cast<int>(values.size()), values.data(), nullptr, nullptr, format);
+    }
+
+    // 以 CParamArena 中的参数执行已准备的语句，稳定状态下参数部分不分配内存
+    CPgResult ExecPrepared(const std::string &name, CParamArena &params, ResultFormat format = TEXT)
+    {
+        return ExecPrepared(name, params.Size(), params.Values(), params.Lengths(), nullptr, format);
+    }
+
+private:
+    // 检查执行结果，失败时抛出 std::runtime_error
+    CPgResult Check(PGresult *raw, const std::string &what)
+    {
+        CPgResult res(raw);
+        ExecStatusType status = raw ? PQresultStatus(raw) : PGRES_FATAL_ERROR;
+        if (status != PGRES_TUPLES_OK && status != PGRES_COMMAND_OK)
+        {
+            throw std::runtime_error(std::string("执行失败 [") + what + "]: " +
+                                     (raw ? PQresultErrorMessage(raw) : PQerrorMessage(conn_.get())));
+        }
+        return res;
+    }
+
+    std::unique_ptr<PGconn, decltype(&PQfinish)> conn_;
+};
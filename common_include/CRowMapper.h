@@ -0,0 +1,140 @@
+#pragma once
+
+// 编译期行映射器：把 pqxx::result 的行映射为应用结构体
+// 每个 result 只按列名查找一次列序号，之后按序号取值；
+// std::string_view 成员直接指向 result 内部缓冲区，不产生堆分配
+// 注意：映射出的 string_view 只在对应 pqxx::result 存活期间有效
+//
+// 用法：
+//   struct User { int id; std::string_view username; };
+//   template <> struct RowMapping<User>
+//   {
+//       static constexpr auto columns = std::make_tuple(
+//           MapColumn("id", &User::id),
+//           MapColumn("username", &User::username));
+//   };
+//   CRowMapper<User> mapper(result);
+//   for (size_t i = 0; i < mapper.Size(); ++i) { User u = mapper[i]; ... }
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <pqxx/pqxx>
+
+// 一列与一个结构体成员的绑定关系
+template <typename T, typename M>
+struct ColumnBinding
+{
+    const char *name; // 列名
+    M T::*member;     // 成员指针
+};
+
+template <typename T, typename M>
+constexpr ColumnBinding<T, M> MapColumn(const char *name, M T::*member)
+{
+    return ColumnBinding<T, M>{name, member};
+}
+
+// 由使用者为每个结构体特化，提供 static constexpr columns（ColumnBinding 的 tuple）
+template <typename T>
+struct RowMapping;
+
+namespace row_mapper_detail
+{
+    // 字段转换：字符串类型零拷贝，其余类型交给 pqxx 转换
+    template <typename M>
+    struct FieldReader
+    {
+        static M Read(const pqxx::field &field) { return field.as<M>(); }
+    };
+
+    template <>
+    struct FieldReader<std::string_view>
+    {
+        // NULL 映射为空串
+        static std::string_view Read(const pqxx::field &field) { return field.view(); }
+    };
+
+    template <typename M>
+    struct FieldReader<std::optional<M>>
+    {
+        static std::optional<M> Read(const pqxx::field &field)
+        {
+            if (field.is_null())
+                return std::nullopt;
+            return FieldReader<M>::Read(field);
+        }
+    };
+}
+
+template <typename T>
+class CRowMapper
+{
+public:
+    static constexpr size_t COLUMN_COUNT = std::tuple_size_v<decltype(RowMapping<T>::columns)>;
+
+    // 绑定 result：按列名查找一次列序号，列不存在时抛出 pqxx::argument_error
+    explicit CRowMapper(const pqxx::result &result) : result_(result)
+    {
+        BindColumns(result_, std::make_index_sequence<COLUMN_COUNT>{});
+    }
+
+    // 按单行绑定列序号（该行所在的 result 不可得时使用），之后通过 Map 映射同布局的行
+    explicit CRowMapper(const pqxx::row &row)
+    {
+        BindColumns(row, std::make_index_sequence<COLUMN_COUNT>{});
+    }
+
+    size_t Size() const { return static_cast<size_t>(result_.size()); }
+    bool Empty() const { return result_.empty(); }
+
+    // 映射第 i 行
+    T operator[](size_t i) const { return Map(result_[static_cast<pqxx::result::size_type>(i)]); }
+
+    // 映射任意一行（该行须来自绑定的 result 或列布局相同的 result）
+    T Map(const pqxx::row &row) const
+    {
+        T obj{};
+        MapColumns(row, obj, std::make_index_sequence<COLUMN_COUNT>{});
+        return obj;
+    }
+
+    // 逐行映射并回调
+    template <typename Fn>
+    void ForEach(Fn &&fn) const
+    {
+        for (const auto &row : result_)
+        {
+            fn(Map(row));
+        }
+    }
+
+private:
+    // source 为 pqxx::result 或 pqxx::row，二者都提供 column_number
+    template <typename Source, size_t... I>
+    void BindColumns(const Source &source, std::index_sequence<I...>)
+    {
+        ((indices_[I] = source.column_number(std::get<I>(RowMapping<T>::columns).name)), ...);
+    }
+
+    template <size_t... I>
+    void MapColumns(const pqxx::row &row, T &obj, std::index_sequence<I...>) const
+    {
+        (ReadColumn<I>(row, obj), ...);
+    }
+
+    template <size_t I>
+    void ReadColumn(const pqxx::row &row, T &obj) const
+    {
+        constexpr auto binding = std::get<I>(RowMapping<T>::columns);
+        using M = std::remove_reference_t<decltype(obj.*(binding.member))>;
+        obj.*(binding.member) = row_mapper_detail::FieldReader<M>::Read(row[indices_[I]]);
+    }
+
+    pqxx::result result_;
+    std::array<pqxx::row::size_type, COLUMN_COUNT> indices_{};
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+// 基于 COPY TO STDOUT 的流式查询
+// 通过 transaction_base::stream()（libpqxx 中取代 stream_from 构造函数的接口）逐行读取并转换为类型化 tuple，
+// 客户端内存占用与结果集大小无关，适合扫描百万行级别的表
+
+#include <cstddef>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <pqxx/pqxx>
+
+// 1、逐行回调：fn 以展开后的列值为参数，如 fn(int id, std::string_view name, ...)
+//    sql 必须是可放入 COPY (...) TO STDOUT 的查询，不支持参数占位符
+//    列类型为 std::string_view 时，其内容只在本次回调内有效
+//    返回处理的行数
+template <typename... Ts, typename Fn>
+size_t StreamQuery(pqxx::transaction_base &tx, pqxx::zview sql, Fn &&fn)
+{
+    size_t rows = 0;
+    for (const std::tuple<Ts...> &row : tx.stream<Ts...>(sql))
+    {
+        std::apply(fn, row);
+        ++rows;
+    }
+    return rows;
+}
+
+// 2、逐行回调：fn 以整行 tuple 为参数，便于转交给其他组件
+template <typename... Ts, typename Fn>
+size_t StreamQueryRows(pqxx::transaction_base &tx, pqxx::zview sql, Fn &&fn)
+{
+    size_t rows = 0;
+    for (const std::tuple<Ts...> &row : tx.stream<Ts...>(sql))
+    {
+        fn(row);
+        ++rows;
+    }
+    return rows;
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+// 编译期类型化查询描述
+// 一条查询只声明一次：语句名、SQL、参数类型和结果列类型都固定在类型上，
+//   struct FindUserBrief : TypedQuery<FindUserBrief, Params<int>, Row<int, std::string_view>>
+//   {
+//       static constexpr const char *name = "find_user_brief";
+//       static constexpr const char *sql = "SELECT id, username FROM users WHERE id = $1";
+//   };
+//   FindUserBrief::Prepare(conn);                 // 准备并校验参数个数、结果列数
+//   auto rows = FindUserBrief::Exec(txn, 42);     // 参数按 Params 的类型传入
+//   rows.ForEach([](int id, std::string_view username) { ... });
+//
+// - 语句名是编译期常量，执行时直接作为 pqxx::prepped 传入，不做任何按名称的查找或哈希；
+//   连接池中的连接经 CStatementRegistry（RegisterTyped / ExecTyped）使用，登记时为每个查询类型分配序号，
+//   每个连接上是否已准备按序号记录（vector 下标访问）
+// - 结果列按序号转换为 Row 中声明的类型（转换规则同 CRowMapper：string_view 零拷贝，optional 表示可空列）
+// - 准备后从 pg_prepared_statements 读取参数个数和结果列数，与声明不一致时抛出 std::logic_error；
+//   结果列信息需要 PostgreSQL 16+，更早的版本 Validate 只校验参数个数并返回 false，
+//   列数在每次取得结果时（TypedResult 构造）校验
+//
+// C++17 不支持字符串字面量作为模板参数，语句名和 SQL 通过派生类的 static constexpr 成员给出（CRTP）
+
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <pqxx/pqxx>
+
+#include "CRowMapper.h"
+
+// 参数类型列表
+template <typename... T>
+struct Params
+{
+};
+
+// 结果列类型列表
+template <typename... T>
+struct Row
+{
+};
+
+// 类型化的查询结果：持有 pqxx::result，按 Row 声明的类型逐行转换
+// 注意：string_view 列只在本对象（或复制出的 pqxx::result）存活期间有效
+template <typename... R>
+class TypedResult
+{
+public:
+    using Tuple = std::tuple<R...>;
+    static constexpr size_t COLUMN_COUNT = sizeof...(R);
+
+    // 列数与声明不一致时抛出 std::logic_error
+    // （PostgreSQL 16 之前的服务端无法在准备时校验列数，由这里兜底；只比较一个整数）
+    TypedResult(pqxx::result result, const char *name) : result_(std::move(result))
+    {
+        if (static_cast<size_t>(result_.columns()) != COLUMN_COUNT)
+        {
+            throw std::logic_error(std::string("类型化查询 ") + name + " 返回 " +
+                                   std::to_string(result_.columns()) + " 列，声明为 " +
+                                   std::to_string(COLUMN_COUNT) + " 列");
+        }
+    }
+
+    size_t Size() const { return static_cast<size_t>(result_.size()); }
+    bool Empty() const { return result_.empty(); }
+
+    // 第 i 行
+    Tuple operator[](size_t i) const { return Read(result_[static_cast<pqxx::result::size_type>(i)]); }
+
+    // 第一行，没有结果时返回 std::nullopt
+    std::optional<Tuple> First() const
+    {
+        if (result_.empty())
+            return std::nullopt;
+        return Read(result_[0]);
+    }
+
+    // 逐行回调 fn(R...)
+    template <typename Fn>
+    void ForEach(Fn &&fn) const
+    {
+        for (const auto &row : result_)
+        {
+            std::apply(fn, Read(row));
+        }
+    }
+
+    const pqxx::result &Raw() const { return result_; }
+
+private:
+    static Tuple Read(const pqxx::row &row)
+    {
+        return Read(row, std::index_sequence_for<R...>{});
+    }
+
+    template <size_t... I>
+    static Tuple Read(const pqxx::row &row, std::index_sequence<I...>)
+    {
+        return Tuple(row_mapper_detail::FieldReader<R>::Read(row[static_cast<pqxx::row::size_type>(I)])...);
+    }
+
+    pqxx::result result_;
+};
+
+template <typename Derived, typename ParamList, typename RowList>
+class TypedQuery;
+
+template <typename Derived, typename... P, typename... R>
+class TypedQuery<Derived, Params<P...>, Row<R...>>
+{
+public:
+    using Result = TypedResult<R...>;
+    static constexpr size_t PARAM_COUNT = sizeof...(P);
+    static constexpr size_t COLUMN_COUNT = sizeof...(R);
+
+    // 1、在连接上准备语句并校验参数个数、结果列数，不一致时抛出 std::logic_error（校验范围见 Validate）
+    //    （连接上不能有进行中的事务；连接池中的连接请通过 CStatementRegistry::RegisterTyped 登记）
+    static void Prepare(pqxx::connection &conn)
+    {
+        conn.prepare(Derived::name, Derived::sql);
+        pqxx::nontransaction tx(conn);
+        Validate(tx);
+    }
+
+    // 2、执行（语句须已准备）
+    static Result Exec(pqxx::transaction_base &tx, const P &...params)
+    {
+        return Result(tx.exec(pqxx::prepped{Derived::name}, Bind(params...)), Derived::name);
+    }
+
+    // 3、按声明的参数类型构造参数列表
+    static pqxx::params Bind(const P &...params) { return pqxx::params{params...}; }
+
+    // 4、校验 tx 所在连接上已准备的同名语句：参数个数或结果列数与声明不一致时抛出 std::logic_error；
+    //    服务端低于 PostgreSQL 16（不提供结果列信息）时只校验参数个数并返回 false，列数推迟到取得结果时校验
+    static bool Validate(pqxx::transaction_base &tx)
+    {
+        // 结果列信息 result_types 从 PostgreSQL 16 开始提供
+        const bool has_result_types = tx.conn().server_version() >= 160000;
+        pqxx::row row = tx.exec(has_result_types
+                                    ? "SELECT cardinality(parameter_types), cardinality(result_types) "
+                                      "FROM pg_prepared_statements WHERE name = $1"
+                                    : "SELECT cardinality(parameter_types), NULL::int "
+                                      "FROM pg_prepared_statements WHERE name = $1",
+                                pqxx::params{Derived::name})
+                            .one_row();
+
+        const size_t params = row[0].as<size_t>();
+        if (params != PARAM_COUNT)
+        {
+            throw std::logic_error(std::string("类型化查询 ") + Derived::name + " 需要 " +
+                                   std::to_string(params) + " 个参数，声明为 " +
+                                   std::to_string(PARAM_COUNT) + " 个");
+        }
+
+        if (!has_result_types)
+            return false;
+
+        // 不返回结果的语句（INSERT/UPDATE 等）result_types 为 NULL
+        const size_t columns = row[1].is_null() ? 0 : row[1].as<size_t>();
+        if (columns != COLUMN_COUNT)
+        {
+            throw std::logic_error(std::string("类型化查询 ") + Derived::name + " 返回 " +
+                                   std::to_string(columns) + " 列，声明为 " +
+                                   std::to_string(COLUMN_COUNT) + " 列");
+        }
+        return true;
+    }
+};
@@ -0,0 +1,274 @@
+#pragma once
+
+// 组提交写入批处理器
+// 多个线程提交的小型写语句由一个后台线程收集，凑满 max_statements 条或等待 max_delay 后
+// 在同一个事务中执行并一次性提交，再逐个完成调用者的 future。
+// 多条语句共享一次 WAL 刷盘，以少量延迟换取成倍的写入吞吐。
+//
+// 批内任一语句失败时整个事务回滚，随后逐条在独立事务中重放，
+// 只有真正出错的语句以异常结束，其余语句正常提交。
+// 设置 CBatchController 后，每批语句数和等待时长按每批的执行耗时自动调整。
+// 批处理器使用独立连接，不受 CQueryWatchdog 管理；SetStatementTimeout 设置服务端超时，
+// 超时被取消的批次整体以异常结束（不再逐条重放），使单批耗时和 Stop 的等待时间都有上界
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pqxx/pqxx>
+
+#include "CBatchController.h"
+
+// 批处理统计
+struct WriteBatcherStats
+{
+    uint64_t statements = 0; // 已执行语句数
+    uint64_t batches = 0;    // 提交的批次数
+    uint64_t replays = 0;    // 因批内失败而逐条重放的批次数
+    uint64_t failures = 0;   // 失败的语句数
+
+    double AvgBatchSize() const { return batches ? double(statements) / double(batches) : 0.0; }
+};
+
+class CWriteBatcher
+{
+public:
+    // conn_str: 批处理器专用连接；max_statements: 每批最多语句数；max_delay: 一批的最长等待时间
+    CWriteBatcher(const std::string &conn_str, size_t max_statements, std::chrono::microseconds max_delay)
+        : conn_str_(conn_str), conn_(std::make_unique<pqxx::connection>(conn_str)),
+          max_statements_(max_statements > 0 ? max_statements : 1), max_delay_(max_delay)
+    {
+        worker_ = std::thread(&CWriteBatcher::Run, this);
+    }
+
+    // 析构时提交剩余请求后退出
+    ~CWriteBatcher() { Stop(); }
+
+    CWriteBatcher(const CWriteBatcher &) = delete;
+    CWriteBatcher &operator=(const CWriteBatcher &) = delete;
+
+    // 提交一条写语句，future 在其所在批次提交后返回受影响行数
+    std::future<size_t> Submit(std::string sql, pqxx::params params = {})
+    {
+        Request request{std::move(sql), std::move(params), {}};
+        std::future<size_t> future = request.promise.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stop_)
+            {
+                request.promise.set_exception(
+                    std::make_exception_ptr(std::runtime_error("写入批处理器已停止")));
+                return future;
+            }
+            queue_.push_back(std::move(request));
+        }
+        cv_.notify_one();
+        return future;
+    }
+
+    // 停止后台线程（已提交的请求会被执行完）
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stop_)
+                return;
+            stop_ = true;
+        }
+        cv_.notify_one();
+        if (worker_.joinable())
+            worker_.join();
+    }
+
+    // 由控制器调整每批语句数和最长等待时间（控制器须比批处理器存活更久，传 nullptr 取消）
+    void SetController(CBatchController *controller)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        controller_ = controller;
+    }
+
+    // 每条语句的服务端超时（statement_timeout），0 表示不限；从下一批开始生效
+    void SetStatementTimeout(std::chrono::milliseconds timeout)
+    {
+        statement_timeout_ms_ = static_cast<int64_t>(timeout.count() > 0 ? timeout.count() : 0);
+    }
+
+    WriteBatcherStats GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    struct Request
+    {
+        std::string sql;
+        pqxx::params params;
+        std::promise<size_t> promise;
+    };
+
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            // 1、等待第一条请求
+            cv_.wait(lock, [this]
+                     { return stop_ || !queue_.empty(); });
+            if (queue_.empty())
+                return; // stop_ 且无剩余请求
+
+            // 2、从第一条请求起最多再等待 max_delay，期间凑满即提前执行
+            CBatchController *controller = controller_;
+            const size_t max_statements = controller ? controller->BatchSize() : max_statements_;
+            auto deadline = std::chrono::steady_clock::now() +
+                            (controller ? controller->FlushInterval() : max_delay_);
+            cv_.wait_until(lock, deadline, [this, max_statements]
+                           { return stop_ || queue_.size() >= max_statements; });
+
+            std::vector<Request> batch;
+            size_t n = std::min(queue_.size(), max_statements);
+            batch.reserve(n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+
+            lock.unlock();
+            ExecuteBatch(batch, controller);
+            lock.lock();
+        }
+    }
+
+    // 连接断开后重新建立（pqxx::connection 不会自动重连），并同步 statement_timeout
+    // （须在连接上开启事务之前调用）
+    pqxx::connection &Conn()
+    {
+        if (!conn_ || !conn_->is_open())
+        {
+            conn_.reset();
+            conn_ = std::make_unique<pqxx::connection>(conn_str_);
+            session_timeout_ms_ = 0;
+        }
+        const int64_t timeout_ms = statement_timeout_ms_;
+        if (session_timeout_ms_ != timeout_ms)
+        {
+            conn_->set_session_var("statement_timeout", std::to_string(timeout_ms));
+            session_timeout_ms_ = timeout_ms;
+        }
+        return *conn_;
+    }
+
+    void ExecuteBatch(std::vector<Request> &batch, CBatchController *controller)
+    {
+        std::vector<size_t> affected;
+        affected.reserve(batch.size());
+        const auto start = std::chrono::steady_clock::now();
+        try
+        {
+            // 整批在一个事务中执行，只等待一次提交
+            pqxx::work tx(Conn());
+            for (auto &request : batch)
+            {
+                affected.push_back(static_cast<size_t>(tx.exec(request.sql, request.params).affected_rows()));
+            }
+            tx.commit();
+        }
+        catch (const pqxx::in_doubt_error &)
+        {
+            // 提交结果未知：重放可能导致重复写入，只能把异常交给所有调用者
+            FailBatch(batch, controller);
+            return;
+        }
+        catch (const pqxx::query_canceled &)
+        {
+            // 超时被取消：逐条重放可能再次逐条超时，整批以异常结束
+            FailBatch(batch, controller);
+            return;
+        }
+        catch (const std::exception &)
+        {
+            Replay(batch);
+            return;
+        }
+
+        if (controller)
+            controller->Observe(batch.size(), std::chrono::steady_clock::now() - start);
+
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            batch[i].promise.set_value(affected[i]);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.statements += batch.size();
+        ++stats_.batches;
+    }
+
+    // 把当前异常交给批内所有调用者
+    void FailBatch(std::vector<Request> &batch, CBatchController *controller)
+    {
+        if (controller)
+            controller->ObserveError();
+        std::exception_ptr error = std::current_exception();
+        for (auto &request : batch)
+        {
+            request.promise.set_exception(error);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.statements += batch.size();
+        ++stats_.batches;
+        stats_.failures += batch.size();
+    }
+
+    // 批内有语句失败：逐条重放，把错误只交给出错的调用者
+    void Replay(std::vector<Request> &batch)
+    {
+        uint64_t failures = 0;
+        for (auto &request : batch)
+        {
+            try
+            {
+                pqxx::work tx(Conn());
+                size_t rows = static_cast<size_t>(tx.exec(request.sql, request.params).affected_rows());
+                tx.commit();
+                request.promise.set_value(rows);
+            }
+            catch (...)
+            {
+                ++failures;
+                request.promise.set_exception(std::current_exception());
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.statements += batch.size();
+        stats_.batches += batch.size();
+        ++stats_.replays;
+        stats_.failures += failures;
+    }
+
+    std::string conn_str_;
+    std::unique_ptr<pqxx::connection> conn_;
+    int64_t session_timeout_ms_ = 0;              // 当前连接上的 statement_timeout（只在后台线程中访问）
+    std::atomic<int64_t> statement_timeout_ms_{0};
+    size_t max_statements_;
+    std::chrono::microseconds max_delay_;
+    CBatchController *controller_ = nullptr; // 在 mutex_ 下读写
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Request> queue_;
+    bool stop_ = false;
+    WriteBatcherStats stats_;
+    std::thread worker_;
+};
@@ -5,9 +5,24 @@
 #include <iostream>
 #include <pqxx/pqxx>
 
+#include "CBulkUpserter.h"
+#include "CBulkWriter.h"
+#include "CColumnarResult.h"
+#include "CPgConn.h"
+#include "CWriteBatcher.h"
+#include "CStreamQuery.h"
+#include "CTypedQuery.h"
+
 using namespace std;
 using namespace pqxx;
 
+// 类型化查询描述（示例 14）：语句名、SQL、参数类型和结果列类型只声明一次
+struct FindCompanyById : TypedQuery<FindCompanyById, Params<int>, Row<int, std::string_view, int, float>>
+{
+    static constexpr const char *name = "find_company_by_id";
+    static constexpr const char *sql = "SELECT ID, NAME, AGE, SALARY FROM COMPANY_1 WHERE ID = $1;";
+};
+
 int main(int argc, char *argv[])
 {
     // 设置控制台编码为UTF-8
@@ -116,6 +131,148 @@ int main(int argc, char *argv[])
         //     }
         // }
 
+        // // 6、使用 COPY 批量插入数据（替代拼接多条 INSERT 语句）
+        // {
+        //     CBulkWriter<int, std::string, int, std::string, float> writer(
+        //         conn, "COMPANY_1", {"ID", "NAME", "AGE", "ADDRESS", "SALARY"}, 5000);
+        //     for (int i = 100; i < 100100; ++i)
+        //     {
+        //         writer.Add(i, "Name" + std::to_string(i), 20 + i % 40, "Address", 10000.0f + i % 5000);
+        //     }
+        //     writer.Flush(); // 写入最后不足 flush_rows 的部分
+        //     const BulkStats &stats = writer.GetStats();
+        //     cout << "COPY rows: " << stats.rows << ", flushes: " << stats.flushes
+        //          << ", rows/sec: " << stats.RowsPerSec()
+        //          << ", bytes/sec: " << stats.BytesPerSec() << endl;
+        // }
+
+        // // 7、流式读取全表（逐行转换，内存占用恒定，不会一次性加载整个 result）
+        // {
+        //     pqxx::nontransaction ntx(conn);
+        //     size_t rows = StreamQuery<int, std::string_view, int, std::string_view, float>(
+        //         ntx, "SELECT ID, NAME, AGE, ADDRESS, SALARY FROM COMPANY_1",
+        //         [](int id, std::string_view name, int age, std::string_view address, float salary)
+        //         {
+        //             cout << "ID = " << id << ", NAME = " << name << ", AGE = " << age
+        //                  << ", ADDRESS = " << address << ", SALARY = " << salary << endl;
+        //         });
+        //     cout << "Streamed rows: " << rows << endl;
+        // }
+
+        // // 8、按列存储后在客户端做统计（连续数组，便于编译器向量化）
+        // {
+        //     pqxx::nontransaction ntx(conn);
+        //     CColumnarResult columns(ntx.exec("SELECT AGE, SALARY FROM COMPANY_1;"));
+        //     const ColumnData &age = columns.Get("age");
+        //     const ColumnData &salary = columns.Get("salary");
+        //     int32_t max_age = 0;
+        //     double total_salary = 0.0;
+        //     for (size_t i = 0; i < columns.Rows(); ++i)
+        //     {
+        //         max_age = std::max(max_age, age.i32[i]);
+        //         total_salary += salary.f64[i]; // NULL 存为 0，不影响求和
+        //     }
+        //     cout << "Max age in COMPANY_1: " << max_age << endl;
+        //     cout << "Avg salary in COMPANY_1: "
+        //          << (columns.Rows() - salary.null_count > 0 ? total_salary / (columns.Rows() - salary.null_count) : 0.0) << endl;
+        // }
+
+        // // 9、以二进制格式接收数值列（服务端不格式化文本，客户端直接按网络字节序解码）
+        // {
+        //     CPgConn pg("dbname = testDB1 user = lzy password = lzy hostaddr = 127.0.0.1 port = 5432");
+        //     CPgResult res = pg.Exec("SELECT ID, AGE, SALARY FROM COMPANY_1 WHERE AGE > $1;",
+        //                             {"20"}, CPgConn::BINARY);
+        //     for (int i = 0; i < res.Rows(); ++i)
+        //     {
+        //         cout << "ID = " << res.GetInt32(i, 0) << endl;
+        //         cout << "AGE = " << res.GetInt32(i, 1) << endl;
+        //         cout << "SALARY = " << (res.IsNull(i, 2) ? 0.0 : res.GetDouble(i, 2)) << endl;
+        //     }
+        // }
+
+        // // 10、多线程小事务更新：组提交，多条 UPDATE 共用一个事务和一次提交
+        // {
+        //     CWriteBatcher batcher("dbname = testDB1 user = lzy password = lzy hostaddr = 127.0.0.1 port = 5432",
+        //                           64, std::chrono::microseconds(2000));
+        //     std::vector<std::thread> writers;
+        //     for (int t = 0; t < 8; ++t)
+        //     {
+        //         writers.emplace_back([&batcher, t]
+        //         {
+        //             for (int i = 1; i <= 4; ++i)
+        //             {
+        //                 std::future<size_t> done = batcher.Submit(
+        //                     "UPDATE COMPANY_1 SET SALARY = $1 WHERE ID = $2;",
+        //                     pqxx::params{25000.0f + t, i});
+        //                 done.get(); // 所在批次提交后返回
+        //             }
+        //         });
+        //     }
+        //     for (auto &writer : writers)
+        //         writer.join();
+        //     WriteBatcherStats stats = batcher.GetStats();
+        //     cout << "Statements: " << stats.statements << ", batches: " << stats.batches
+        //          << ", avg batch size: " << stats.AvgBatchSize() << endl;
+        // }
+
+        // // 11、复用参数缓冲区执行预处理语句：循环中参数转换不再分配内存
+        // {
+        //     CPgConn pg("dbname = testDB1 user = lzy password = lzy hostaddr = 127.0.0.1 port = 5432");
+        //     pg.Prepare("update_salary", "UPDATE COMPANY_1 SET SALARY = $1 WHERE ID = $2;");
+        //     CParamArena &arena = CParamArena::ThreadLocal();
+        //     for (int i = 1; i <= 4; ++i)
+        //     {
+        //         arena.Reset().Add(30000.0 + i).Add(i);
+        //         pg.ExecPrepared("update_salary", arena);
+        //     }
+        // }
+
+        // // 12、批量合并：COPY 到临时暂存表，再一条 INSERT ... ON CONFLICT DO UPDATE 合并到 COMPANY_1
+        // {
+        //     CBulkUpserter<int, std::string, int, std::string, float> upserter(
+        //         conn, "COMPANY_1", {"ID", "NAME", "AGE", "ADDRESS", "SALARY"}, {"ID"});
+        //     for (int i = 1; i <= 20000; ++i)
+        //     {
+        //         upserter.Add(i, "Name" + std::to_string(i), 20 + i % 40, "Address", 12000.0f + i % 3000);
+        //     }
+        //     UpsertResult result = upserter.Merge();
+        //     cout << "Staged: " << result.staged << ", inserted: " << result.inserted
+        //          << ", updated: " << result.updated << ", unchanged: " << result.unchanged
+        //          << ", seconds: " << result.seconds << endl;
+        // }
+
+        // // 13、自适应批大小：每次 COPY 的行数按单批耗时自动调整（超过 50 ms 减半，否则逐步增大）
+        // {
+        //     BatchControlOptions control;
+        //     control.initial_size = 1000;
+        //     control.max_size = 50000;
+        //     control.target_latency = std::chrono::milliseconds(50);
+        //     CBatchController controller(control);
+        //     CBulkWriter<int, std::string, int, std::string, float> writer(
+        //         conn, "COMPANY_1", {"ID", "NAME", "AGE", "ADDRESS", "SALARY"});
+        //     writer.SetController(&controller);
+        //     for (int i = 200000; i < 300000; ++i)
+        //     {
+        //         writer.Add(i, "Name" + std::to_string(i), 20 + i % 40, "Address", 10000.0f + i % 5000);
+        //     }
+        //     writer.Flush();
+        //     BatchControlStats stats = controller.GetStats();
+        //     cout << "Batch size: " << stats.batch_size << ", batches: " << stats.batches
+        //          << ", avg latency: " << stats.avg_latency_ms << " ms" << endl;
+        // }
+
+        // // 14、类型化查询：准备时校验参数个数和结果列数，结果按声明的类型逐列转换，不再逐个 as<T>()
+        // {
+        //     FindCompanyById::Prepare(conn);
+        //     pqxx::nontransaction ntx(conn);
+        //     FindCompanyById::Exec(ntx, 1).ForEach(
+        //         [](int id, std::string_view name, int age, float salary)
+        //         {
+        //             cout << "ID = " << id << ", NAME = " << name << ", AGE = " << age
+        //                  << ", SALARY = " << salary << endl;
+        //         });
+        // }
+
     conn.close();
 }
 catch (const std::exception &e) // 捕获一般标准异常
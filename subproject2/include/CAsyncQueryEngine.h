@@ -0,0 +1,106 @@
+#pragma once
+
+// 基于 epoll 的单线程异步查询引擎
+// 一个事件循环线程以非阻塞方式驱动多个 libpq 连接（PQsendQueryParams / PQconsumeInput / PQisBusy），
+// 所有连接的 socket 注册到同一个 epoll 实例，请求完成后通过回调或 future 返回结果。
+// 这样一个核心即可保持数百个查询同时在途，而不必为每个查询挂起一个线程。
+// 每个请求从发出到完成的耗时、行数和字节数按 metrics_name 记入 CQueryMetrics（不含排队等待连接的时间）
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CPgConn.h"
+
+class CAsyncQueryEngine
+{
+public:
+    // 请求参数：文本格式，std::nullopt 表示 NULL
+    using Params = std::vector<std::optional<std::string>>;
+    // 完成回调：成功时 error 为空；回调在事件循环线程中执行，应尽快返回
+    using Callback = std::function<void(CPgResult result, std::exception_ptr error)>;
+
+    // conn_str: 连接字符串；connection_count: 连接数（即最大在途查询数）；metrics_name: 指标中的语句名
+    // 连接在构造时同步建立，失败时抛出 std::runtime_error
+    CAsyncQueryEngine(const std::string &conn_str, int connection_count,
+                      std::string metrics_name = "async_query");
+    ~CAsyncQueryEngine();
+
+    CAsyncQueryEngine(const CAsyncQueryEngine &) = delete;
+    CAsyncQueryEngine &operator=(const CAsyncQueryEngine &) = delete;
+
+    // 1、提交查询，完成后调用 callback
+    void Submit(std::string sql, Params params, Callback callback,
+                CPgConn::ResultFormat format = CPgConn::TEXT);
+
+    // 2、提交查询，通过 future 获取结果（失败时 future.get() 抛出异常）
+    std::future<CPgResult> Submit(std::string sql, Params params = {},
+                                  CPgConn::ResultFormat format = CPgConn::TEXT);
+
+    // 3、停止事件循环：向在途查询发送取消请求（PQcancel），尚未完成的请求以异常结束
+    void Stop();
+
+    size_t InFlight() const { return in_flight_.load(); }
+    size_t Pending() const;
+    size_t Completed() const { return completed_.load(); }
+
+private:
+    struct Request
+    {
+        std::string sql;
+        Params params;
+        CPgConn::ResultFormat format;
+        Callback callback;
+        std::chrono::steady_clock::time_point start; // 发往连接的时间
+    };
+
+    // 一个连接及其当前执行的请求
+    struct Slot
+    {
+        std::unique_ptr<CPgConn> conn;
+        int fd = -1;
+        bool alive = true;
+        bool want_write = false;         // 发送缓冲区未写完，需要关注 EPOLLOUT
+        std::unique_ptr<Request> request; // 为空表示空闲
+        CPgResult result;                 // 当前请求的最后一个结果
+        std::string error;                // 当前请求的错误信息
+    };
+
+    void Run();
+    void Dispatch();
+    bool Send(size_t index);
+    void OnReadable(size_t index);
+    void OnWritable(size_t index);
+    void Finish(size_t index);
+    void Fail(std::unique_ptr<Request> request, const std::string &message);
+    void UpdateEvents(Slot &slot);
+    void KillSlot(size_t index, const std::string &message);
+    void Wakeup();
+    void CancelBusy();
+    void RecordError(const Request &request);
+
+    int epoll_fd_ = -1;
+    int event_fd_ = -1; // 用于唤醒事件循环（新请求或停止）
+    std::string metrics_name_;
+
+    std::vector<Slot> slots_;    // 只在事件循环线程中访问（构造完成后）
+    std::vector<size_t> idle_;   // 空闲连接下标
+    size_t alive_count_ = 0;     // 未损坏的连接数
+
+    mutable std::mutex mutex_;
+    std::deque<std::unique_ptr<Request>> pending_; // 等待分配连接的请求
+
+    std::atomic<bool> stop_{false};
+    std::atomic<size_t> in_flight_{0};
+    std::atomic<size_t> completed_{0};
+    std::thread loop_;
+};
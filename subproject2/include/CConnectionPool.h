@@ -0,0 +1,155 @@
+#pragma once
+
+// 线程安全的 pqxx 连接池
+// 工作线程通过 RAII 句柄借出连接，句柄析构时自动归还，
+// 避免每次数据库操作都重新建立 TCP 连接、认证和 fork 后端进程。
+// 借出的连接在归还之前一直登记在 CQueryWatchdog 中，程序退出时其上的查询会被取消
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <pqxx/pqxx>
+
+// 池中的一个连接条目
+struct PooledConnection
+{
+    std::unique_ptr<pqxx::connection> conn;
+    std::unordered_set<std::string> prepared;          // 该连接上已准备的语句名
+    std::vector<bool> typed_prepared;                  // 已准备的类型化查询，下标为 CStatementRegistry 分配的序号
+    std::chrono::steady_clock::time_point last_used;   // 最近一次归还的时间
+    int64_t statement_timeout_ms = 0;                  // 该会话当前的 statement_timeout（0 表示不限制）
+};
+
+// 连接池配置参数
+struct PoolOptions
+{
+    std::string conn_str;                                // 连接字符串
+    int min_size = 1;                                    // 最少保持的连接数
+    int max_size = 4;                                    // 最多允许的连接数
+    std::chrono::milliseconds idle_timeout{60000};       // 空闲连接超过该时长后被回收（不低于 min_size）
+    std::chrono::milliseconds checkout_timeout{5000};    // 借出连接的最长等待时间
+    std::function<void(PooledConnection &)> on_connect;  // 新连接建立后的回调（如预先准备语句）
+};
+
+// 连接池运行统计（用于在真实负载下评估池大小）
+struct PoolStats
+{
+    int total = 0;              // 已建立的连接总数
+    int in_use = 0;             // 正在被借出的连接数
+    int idle = 0;               // 空闲连接数
+    int waiting = 0;            // 正在等待借出的线程数
+    uint64_t checkouts = 0;     // 借出总次数
+    uint64_t timeouts = 0;      // 借出超时次数
+    double avg_wait_ms = 0.0;   // 平均借出等待时间（毫秒）
+    double max_wait_ms = 0.0;   // 最长借出等待时间（毫秒）
+};
+
+class CConnectionPool
+{
+public:
+    using Entry = PooledConnection;
+
+    // 借出连接的 RAII 句柄：析构时把连接归还给连接池
+    class Handle
+    {
+    public:
+        Handle() = default;
+        Handle(CConnectionPool *pool, std::unique_ptr<Entry> entry)
+            : pool_(pool), entry_(std::move(entry)) {}
+        ~Handle() { Reset(); }
+
+        Handle(Handle &&other) noexcept
+            : pool_(other.pool_), entry_(std::move(other.entry_)), broken_(other.broken_)
+        {
+            other.pool_ = nullptr;
+        }
+        Handle &operator=(Handle &&other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                pool_ = other.pool_;
+                entry_ = std::move(other.entry_);
+                broken_ = other.broken_;
+                other.pool_ = nullptr;
+            }
+            return *this;
+        }
+        Handle(const Handle &) = delete;
+        Handle &operator=(const Handle &) = delete;
+
+        pqxx::connection &Conn() const { return *entry_->conn; }
+        pqxx::connection *operator->() const { return entry_->conn.get(); }
+        Entry &GetEntry() const { return *entry_; }
+        explicit operator bool() const { return entry_ != nullptr; }
+
+        // 标记连接已损坏：归还时直接关闭而不是放回空闲队列
+        void Invalidate() { broken_ = true; }
+
+        // 提前归还连接
+        void Reset()
+        {
+            if (pool_ && entry_)
+            {
+                pool_->Release(std::move(entry_), broken_);
+            }
+            pool_ = nullptr;
+            entry_.reset();
+            broken_ = false;
+        }
+
+    private:
+        CConnectionPool *pool_ = nullptr;
+        std::unique_ptr<Entry> entry_;
+        bool broken_ = false;
+    };
+
+    explicit CConnectionPool(PoolOptions options);
+    ~CConnectionPool();
+
+    CConnectionPool(const CConnectionPool &) = delete;
+    CConnectionPool &operator=(const CConnectionPool &) = delete;
+
+    // 借出一个连接，超过 checkout_timeout 仍无可用连接或程序正在退出时抛出 std::runtime_error
+    Handle Acquire();
+
+    // 回收空闲时间超过 idle_timeout 的连接（保留 min_size 个）
+    void EvictIdle();
+
+    // 预热：对全部空闲连接并行执行 fn（如准备语句、健康检查），
+    // fn 抛出异常的连接被关闭并移出连接池；返回通过的连接数
+    int Warmup(const std::function<void(Entry &)> &fn);
+
+    // 获取当前统计信息
+    PoolStats GetStats() const;
+
+    // 未完成的请求数：已借出的连接数 + 正在等待借出的线程数（用于最少未完成请求路由）
+    int Outstanding() const;
+
+    const PoolOptions &GetOptions() const { return options_; }
+
+private:
+    void Release(std::unique_ptr<Entry> entry, bool broken);
+    std::unique_ptr<Entry> CreateEntry();
+    void EvictIdleLocked(std::vector<std::unique_ptr<Entry>> &evicted);
+
+    PoolOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::unique_ptr<Entry>> idle_;   // 空闲连接（队尾为最近归还）
+    int total_ = 0;                             // 已建立或正在建立的连接数
+    int in_use_ = 0;
+    int waiting_ = 0;
+    uint64_t checkouts_ = 0;
+    uint64_t timeouts_ = 0;
+    double total_wait_ms_ = 0.0;
+    double max_wait_ms_ = 0.0;
+};
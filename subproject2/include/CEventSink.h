@@ -0,0 +1,154 @@
+#pragma once
+
+// 异步写后（write-behind）事件表写入器
+// 业务线程调用 Emit 只把记录放入有界队列，由专用线程在独立连接上
+// 凑满 flush_rows 条或距本批第一条记录超过 flush_interval 后，通过 COPY（pqxx::stream_to）写入事件表。
+// 内存上限为 capacity + flush_rows 条记录；队列满时按 OverflowPolicy 阻塞、丢弃最旧的记录或丢弃新记录，
+// 与 spdlog::async_overflow_policy 的三种策略一致。日志记录单独使用 log_policy（不允许阻塞），
+// 事件库不可用时不会拖住所有写日志的线程。
+//
+// 写入失败时断开连接，每隔 retry_interval 重试同一批（期间队列继续按溢出策略处理），
+// 提交结果未知时重试可能产生重复记录（至少一次）；Stop 时写完队列中剩余记录，仍失败则丢弃。
+// 写入连接不经过连接池，不受 CQueryWatchdog 管理，由 statement_timeout 限制单次 COPY 的耗时。
+//
+// CEventLogSink 把 g_logger 中 warn 及以上的日志同时写入事件表（见 main.cpp）
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pqxx/pqxx>
+
+#include "CBoundedQueue.h"
+#include "spdlog/sinks/base_sink.h"
+
+// 一条事件记录
+struct EventRecord
+{
+    std::chrono::system_clock::time_point time; // 发生时间
+    std::string kind;                           // 事件类型，日志记录为 "log"
+    std::string level;                          // 级别（业务事件默认 "info"，日志记录为 spdlog 级别名）
+    std::string source;                         // 来源（模块名、logger 名等）
+    std::string payload;                        // 内容
+};
+
+// 写入器配置
+struct EventSinkOptions
+{
+    std::string conn_str;                             // 写入专用连接的连接字符串
+    std::string table = "app_events";                 // 事件表（按原样拼接，只应传入程序内常量）
+    size_t capacity = 10000;                          // 队列中最多缓存的记录数
+    size_t flush_rows = 500;                          // 每次 COPY 最多写入的记录数
+    std::chrono::milliseconds flush_interval{200};    // 本批第一条记录最多等待多久
+    OverflowPolicy policy = OverflowPolicy::BLOCK;    // 队列满时业务事件的处理方式
+    OverflowPolicy log_policy = OverflowPolicy::OVERRUN_OLDEST; // 队列满时日志记录的处理方式，BLOCK 按 OVERRUN_OLDEST 处理
+    std::chrono::milliseconds retry_interval{1000};   // 写入失败后的重试间隔
+    std::chrono::milliseconds statement_timeout{0};   // 写入连接的 statement_timeout，0 表示不限
+};
+
+// 写入统计
+struct EventSinkStats
+{
+    uint64_t emitted = 0;   // Emit 调用次数
+    uint64_t written = 0;   // 已写入事件表的记录数
+    uint64_t discarded = 0; // 队列满（DISCARD_NEW）或已停止时丢弃的新记录数
+    uint64_t overrun = 0;   // 队列满（OVERRUN_OLDEST）时丢弃的最旧记录数
+    uint64_t dropped = 0;   // 停止时仍写入失败而丢弃的记录数
+    uint64_t flushes = 0;   // COPY 次数
+    uint64_t failures = 0;  // COPY 失败次数
+    size_t queued = 0;      // 当前队列中的记录数
+};
+
+class CEventSink
+{
+public:
+    explicit CEventSink(EventSinkOptions options);
+    ~CEventSink(); // 调用 Stop
+
+    CEventSink(const CEventSink &) = delete;
+    CEventSink &operator=(const CEventSink &) = delete;
+
+    // 1、创建事件表（已存在时不做任何操作）
+    static void CreateTable(pqxx::connection &conn, const std::string &table);
+
+    // 2、启动写入线程
+    void Start();
+
+    // 3、停止：不再接受新记录，写完队列中剩余的记录后返回
+    void Stop();
+
+    // 4、提交一条记录；队列满且按策略丢弃了本记录，或写入器已停止时返回 false
+    bool Emit(std::string kind, std::string payload, std::string level = "info", std::string source = {});
+    bool Emit(EventRecord record);
+
+    // 5、提交一条日志记录：按 log_policy 处理，从不阻塞（供 CEventLogSink 使用）
+    bool EmitLog(EventRecord record);
+
+    // 当前线程是否为写入线程（写入线程自身的日志不应再写回事件表）
+    static bool InWriterThread();
+
+    EventSinkStats GetStats() const;
+
+private:
+    void Run();
+    bool Push(EventRecord record, OverflowPolicy policy);
+    bool WriteWithRetry(const std::vector<EventRecord> &batch); // 停止后仍失败时返回 false
+    void Write(const std::vector<EventRecord> &batch);
+    pqxx::connection &Conn();
+
+    EventSinkOptions options_;
+    CBoundedQueue<EventRecord> queue_;
+    std::unique_ptr<pqxx::connection> conn_; // 只在写入线程中使用
+    std::string columns_;
+    std::string metrics_name_; // CQueryMetrics 中的语句名：copy:<表名>
+    std::thread writer_;
+
+    std::mutex stop_mutex_;
+    std::condition_variable stop_cv_; // 重试等待期间用于及时响应 Stop
+    bool stopping_ = false;
+
+    std::atomic<uint64_t> emitted_{0};
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> discarded_{0};
+    std::atomic<uint64_t> overrun_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> flushes_{0};
+    std::atomic<uint64_t> failures_{0};
+};
+
+// 把日志记录转为事件的 spdlog sink，通过 set_level 选择写入的最低级别（通常为 warn）
+template <typename Mutex>
+class CEventLogSink : public spdlog::sinks::base_sink<Mutex>
+{
+public:
+    explicit CEventLogSink(CEventSink &events) : events_(events) {}
+
+protected:
+    void sink_it_(const spdlog::details::log_msg &msg) override
+    {
+        // 写入线程报告写入失败的日志不再回流：写入失败时这些日志只会继续挤占队列
+        if (CEventSink::InWriterThread())
+            return;
+
+        const auto level = spdlog::level::to_string_view(msg.level);
+        EventRecord record;
+        record.time = msg.time;
+        record.kind = "log";
+        record.level.assign(level.data(), level.size());
+        record.source.assign(msg.logger_name.data(), msg.logger_name.size());
+        record.payload.assign(msg.payload.data(), msg.payload.size());
+        events_.EmitLog(std::move(record));
+    }
+
+    void flush_() override {}
+
+private:
+    CEventSink &events_;
+};
+
+using CEventLogSinkMt = CEventLogSink<std::mutex>;
@@ -0,0 +1,118 @@
+#pragma once
+
+// 对冲读请求（hedged request）
+// 幂等的只读查询先发往一个副本；若超过对冲延迟仍未返回，再把同一查询发往另一个副本
+// （没有其他可用副本时为主库上的另一个连接），先返回的结果胜出，另一路用 cancel_query 取消。
+// 对冲延迟取该语句近期延迟的某个分位数（默认 p95），只有约 5% 的请求会多发一次，
+// 单个副本因 vacuum、checkpoint 或网络抖动卡顿时，读请求的 p99 不再被它拖累。
+//
+// 注意：
+//   - 只用于幂等的只读查询，两路可能都执行完成
+//   - fn 可能在 Run 返回之后仍在另一线程中执行（被取消的一路），必须按值捕获参数
+//   - 每一路由 CHedgedReader 自有的 workers 个工作线程执行，调用线程只负责等待；
+//     工作线程全忙时新的一路排队等待。不得在已借出连接的线程中调用（同 CUserLoader）
+//   - 对冲延迟按首发一路的耗时（从发出到返回）统计；首发一路落后时，记录它落后时已经过的时间
+//     （截尾值），避免分布只剩较快的样本、对冲延迟越调越低
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <pqxx/pqxx>
+
+#include "CConnectionPool.h"
+#include "CLatencyHistogram.h"
+#include "CRoutedPool.h"
+
+// 对冲配置
+struct HedgeOptions
+{
+    bool enabled = true;                        // false 时直接在调用线程执行，不对冲
+    double percentile = 0.95;                   // 对冲延迟取近期延迟的该分位数
+    std::chrono::milliseconds min_delay{1};     // 对冲延迟下限，避免在延迟极低时几乎每次都对冲
+    std::chrono::milliseconds max_delay{1000};  // 对冲延迟上限（样本不足时使用该值）
+    uint64_t window = 200;                      // 每累计 window 个样本重新计算一次对冲延迟
+    std::chrono::milliseconds timeout{0};       // 每一路的截止时间（见 CQueryWatchdog），0 表示不限
+    size_t workers = 8;                         // 执行各路查询的工作线程数（同时在途的查询路数上限）
+};
+
+// 对冲统计
+struct HedgeStats
+{
+    uint64_t requests = 0;   // Run 调用次数
+    uint64_t hedged = 0;     // 发出第二路的次数
+    uint64_t hedge_wins = 0; // 第二路先返回的次数
+    uint64_t cancelled = 0;  // 被取消的落后一路
+    uint64_t failed = 0;     // 两路都失败（或未对冲即失败）的请求数
+};
+
+class CHedgedReader
+{
+public:
+    // 查询函数：在借出的连接上执行只读查询
+    using QueryFunc = std::function<pqxx::result(CConnectionPool::Handle &handle)>;
+
+    CHedgedReader(CRoutedPool &pool, HedgeOptions options);
+    ~CHedgedReader(); // 执行完已排队的各路（含落后的一路）后停止工作线程
+
+    CHedgedReader(const CHedgedReader &) = delete;
+    CHedgedReader &operator=(const CHedgedReader &) = delete;
+
+    // 1、执行查询：name 用于按语句区分延迟分布；返回先完成的一路结果，
+    //    两路都失败时重新抛出第一路的异常（整体耗时以 <name>:hedged 记入 CQueryMetrics）
+    pqxx::result Run(const std::string &name, QueryFunc fn);
+
+    // 2、某条语句当前的对冲延迟
+    std::chrono::microseconds CurrentDelay(const std::string &name);
+
+    HedgeStats GetStats() const;
+
+    // 3、输出统计和各语句的对冲延迟到 g_logger
+    void LogStats() const;
+
+private:
+    struct Request; // 一次 Run 的共享状态，落后一路执行完之前一直存在
+
+    // 单条语句的延迟分布和当前对冲延迟
+    struct Policy
+    {
+        CLatencyHistogram latency;           // 首发一路的耗时（微秒，落后时为截尾值），按 window 滚动
+        std::atomic<int64_t> delay_us{0};
+        std::atomic<uint64_t> samples{0};    // 本窗口已记录的样本数
+        std::mutex refresh_mutex;
+    };
+
+    pqxx::result Execute(const std::string &name, QueryFunc fn);
+    Policy &GetPolicy(const std::string &name);
+    void RecordLatency(Policy &policy, std::chrono::steady_clock::duration elapsed);
+    void Launch(const std::shared_ptr<Request> &request, int attempt, int avoid);
+    void Attempt(const std::shared_ptr<Request> &request, int attempt, int avoid);
+    void WorkerLoop();
+
+    CRoutedPool &pool_;
+    HedgeOptions options_;
+
+    mutable std::shared_mutex policies_mutex_;
+    std::unordered_map<std::string, std::unique_ptr<Policy>> policies_;
+
+    std::mutex tasks_mutex_;
+    std::condition_variable tasks_cv_;
+    std::deque<std::function<void()>> tasks_; // 等待执行的各路
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> hedged_{0};
+    std::atomic<uint64_t> hedge_wins_{0};
+    std::atomic<uint64_t> cancelled_{0};
+    std::atomic<uint64_t> failed_{0};
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+// 按范围分区的并行全表扫描
+// 把表按主键范围（或 ctid 块范围）切成 N 段，每段在独立的线程和连接上用服务端游标分块读取，
+// 读到的块经有界队列交给调用线程处理；多核客户端和服务端同时工作，大表导出耗时成倍缩短。
+//
+// consistent_snapshot 为 true 时，协调连接以 REPEATABLE READ 开启事务并导出快照，
+// 各分区事务通过 SET TRANSACTION SNAPSHOT 共享同一快照，结果与单连接扫描一致。
+// 此时共需 partitions + 1 个连接，分区数会被限制为连接池上限减一；否则限制为连接池上限。
+// 连接池上限为 1 时无法再借出分区连接，改为在协调事务上单分区扫描
+//
+// 注意：回调中不得再从同一连接池借出连接（各分区线程可能正占满连接池）
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <pqxx/pqxx>
+
+#include "CConnectionPool.h"
+
+// 分区方式
+enum class ScanPartitioning
+{
+    KEY,  // 按整数主键的取值范围均分
+    CTID  // 按堆表的物理块范围均分（不要求整数主键，需要 PostgreSQL 14+ 的 TID 范围扫描）
+};
+
+// 并行扫描配置
+struct ParallelScanOptions
+{
+    std::string table;                                   // 表名（按原样拼接，只应传入程序内常量）
+    std::string columns = "*";                           // 查询的列
+    std::string key_column = "id";                       // KEY 分区使用的整数主键列
+    ScanPartitioning partitioning = ScanPartitioning::KEY;
+    int partitions = 4;                                  // 分区数（即并行线程数）
+    size_t fetch_size = 10000;                           // 每次从游标取回的行数
+    size_t queue_capacity = 16;                          // 队列中最多缓存的块数
+    bool consistent_snapshot = true;                     // 各分区是否共享同一快照
+};
+
+// 交给回调的一个数据块
+struct ScanChunk
+{
+    int partition = 0; // 所属分区
+    pqxx::result rows;
+};
+
+// 扫描统计
+struct ParallelScanStats
+{
+    uint64_t rows = 0;                  // 总行数
+    uint64_t chunks = 0;                // 总块数
+    std::vector<uint64_t> partition_rows; // 各分区行数
+    double seconds = 0.0;               // 总耗时（秒）
+};
+
+class CParallelScan
+{
+public:
+    using ChunkFunc = std::function<void(const ScanChunk &chunk)>;
+
+    CParallelScan(CConnectionPool &pool, ParallelScanOptions options);
+
+    // 执行扫描：fn 在调用线程中依次处理各分区的数据块（块之间无顺序保证）；
+    // 任一分区或回调出错时停止全部分区并重新抛出第一个异常
+    ParallelScanStats Run(const ChunkFunc &fn);
+
+private:
+    // 分区边界：[lower, upper)，缺省表示不设该侧边界
+    struct Range
+    {
+        bool has_lower = false;
+        bool has_upper = false;
+        int64_t lower = 0;
+        int64_t upper = 0;
+    };
+
+    std::vector<Range> PlanRanges(pqxx::transaction_base &txn, int partitions) const;
+    std::string RangeQuery(const Range &range) const;
+
+    CConnectionPool &pool_;
+    ParallelScanOptions options_;
+};
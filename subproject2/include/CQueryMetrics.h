@@ -0,0 +1,170 @@
+#pragma once
+
+// 按语句名统计的查询指标
+// 每条语句一个延迟直方图（微秒）以及返回行数、字节数和错误数；
+// 后台线程每隔 report_interval 把本时间窗口内的 p50/p90/p99/p999 和吞吐量写入 g_logger，然后清零。
+// 另外可以登记瞬时值（gauge，如自适应批大小），每次报告时读取当前值一并输出。
+// 记录只涉及一次读锁查找和若干原子自增，可在生产环境常开
+//
+// 覆盖范围（语句名）：
+//   - CStatementRegistry::Exec / ExecTyped：按预处理语句名
+//   - CUserDao::FindByIds：<语句名>:pipeline
+//   - CHedgedReader::Run：<语句名>:hedged（调用者看到的整体耗时）
+//   - CParallelScan 各分区：parallel_scan:<表名>；main.cpp 中的游标扫描：cursor_scan:<表名>
+//   - CAsyncQueryEngine：构造时给出的 metrics_name（默认 async_query）
+//   - CEventSink 的 COPY：copy:<表名>
+// common_include 中的 StreamQuery、CBulkWriter、CBulkUpserter、CWriteBatcher 与 subproject1 共用，
+// 不依赖本类，由 subproject2 中的调用处（如 CEventSink）负责记录
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <pqxx/pqxx>
+
+#include "CLatencyHistogram.h"
+
+// 单条语句的指标
+struct StatementMetrics
+{
+    CLatencyHistogram latency;        // 延迟（微秒），含失败的调用
+    std::atomic<uint64_t> rows{0};    // 返回行数
+    std::atomic<uint64_t> bytes{0};   // 返回字段的字节数
+    std::atomic<uint64_t> errors{0};  // 抛出异常的调用数
+};
+
+class CQueryMetrics
+{
+public:
+    // 1、获取单例实例
+    static CQueryMetrics &GetInstance()
+    {
+        static CQueryMetrics instance;
+        return instance;
+    }
+
+    // 2、开关（关闭后 Measure 直接执行，不做任何记录）
+    void SetEnabled(bool enabled) { enabled_ = enabled; }
+    bool Enabled() const { return enabled_; }
+
+    // 3、获取语句的指标，不存在时创建（返回的引用一直有效）
+    StatementMetrics &Get(const std::string &name);
+
+    // 4、记录一次调用（热点路径可先用 Get 取得指标并缓存，再按引用记录，省去按名称查找）
+    void Record(const std::string &name, std::chrono::steady_clock::duration elapsed,
+                size_t rows, size_t bytes);
+    void RecordError(const std::string &name, std::chrono::steady_clock::duration elapsed);
+    static void Record(StatementMetrics &metrics, std::chrono::steady_clock::duration elapsed,
+                       size_t rows, size_t bytes);
+    static void RecordError(StatementMetrics &metrics, std::chrono::steady_clock::duration elapsed);
+
+    // 5、执行 fn 并记录耗时；fn 返回 pqxx::result 或其 vector 时同时统计行数和字节数
+    template <typename Fn>
+    auto Measure(const std::string &name, Fn &&fn) -> decltype(fn())
+    {
+        if (!enabled_)
+            return fn();
+        return Measure(Get(name), std::forward<Fn>(fn));
+    }
+
+    template <typename Fn>
+    auto Measure(StatementMetrics &metrics, Fn &&fn) -> decltype(fn())
+    {
+        if (!enabled_)
+            return fn();
+
+        auto start = std::chrono::steady_clock::now();
+        try
+        {
+            if constexpr (std::is_void_v<decltype(fn())>)
+            {
+                fn();
+                Record(metrics, std::chrono::steady_clock::now() - start, 0, 0);
+            }
+            else
+            {
+                auto result = fn();
+                Record(metrics, std::chrono::steady_clock::now() - start, RowCount(result), ByteCount(result));
+                return result;
+            }
+        }
+        catch (...)
+        {
+            RecordError(metrics, std::chrono::steady_clock::now() - start);
+            throw;
+        }
+    }
+
+    // 6、启动/停止定期报告线程
+    void Start(std::chrono::seconds interval);
+    void Stop();
+
+    // 7、立即输出本时间窗口的统计并清零
+    void Report();
+
+    // 8、登记/注销瞬时值：read 在报告线程中调用，注销之前所引用的对象必须有效
+    void SetGauge(const std::string &name, std::function<double()> read);
+    void RemoveGauge(const std::string &name);
+
+    // 结果中全部字段的字节数
+    static size_t ResultBytes(const pqxx::result &result);
+
+    CQueryMetrics(const CQueryMetrics &) = delete;
+    CQueryMetrics &operator=(const CQueryMetrics &) = delete;
+
+private:
+    CQueryMetrics() = default;
+    ~CQueryMetrics();
+
+    static size_t RowCount(const pqxx::result &result) { return static_cast<size_t>(result.size()); }
+    static size_t ByteCount(const pqxx::result &result) { return ResultBytes(result); }
+
+    static size_t RowCount(const std::vector<pqxx::result> &results)
+    {
+        size_t rows = 0;
+        for (const auto &result : results)
+            rows += static_cast<size_t>(result.size());
+        return rows;
+    }
+
+    static size_t ByteCount(const std::vector<pqxx::result> &results)
+    {
+        size_t bytes = 0;
+        for (const auto &result : results)
+            bytes += ResultBytes(result);
+        return bytes;
+    }
+
+    template <typename T>
+    static size_t RowCount(const T &) { return 0; }
+    template <typename T>
+    static size_t ByteCount(const T &) { return 0; }
+
+    void ReportLoop();
+
+    std::atomic<bool> enabled_{true};
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::unique_ptr<StatementMetrics>> statements_;
+
+    std::mutex gauges_mutex_;
+    std::map<std::string, std::function<double()>> gauges_; // 按名称排序输出
+
+    std::mutex report_mutex_;
+    std::condition_variable report_cv_;
+    bool running_ = false;
+    std::chrono::seconds interval_{0};
+    std::chrono::steady_clock::time_point window_start_ = std::chrono::steady_clock::now();
+    std::thread reporter_;
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+// 查询截止时间与取消
+// 连接池借出的每个连接在借出期间都登记在看门狗中（CConnectionPool::Acquire 登记，归还时注销），
+// 默认没有截止时间；关闭标志置位后，看门狗取消全部已借出连接上的在途查询，
+// 之后借出连接或建立 Scope 会直接抛出 std::runtime_error，使退出耗时有上界。
+// 单次请求在执行查询前建立一个 Scope 设置截止时间：
+//   - 服务端：把连接的 statement_timeout 设为本次请求的超时（与上次相同则不重复 SET）
+//   - 客户端：超过截止时间仍未结束时由看门狗线程调用 cancel_query，
+//     覆盖服务端超时管不到的情况（多条语句累计超时、网络卡顿等）
+// 被取消的查询抛出 pqxx::query_canceled；借出期间发出过取消请求的连接归还时直接关闭，
+// 避免晚到的取消请求误伤下一个借出者
+//
+// 注意：Scope 必须在该连接上开启事务之前建立（SET statement_timeout 需要直接在连接上执行）
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <pqxx/pqxx>
+
+#include "CConnectionPool.h"
+
+// 看门狗统计
+struct WatchdogStats
+{
+    uint64_t checkouts = 0;         // 登记过的借出次数
+    uint64_t scopes = 0;            // 设置过截止时间的请求数
+    uint64_t deadline_cancels = 0;  // 因超过截止时间被取消的请求数
+    uint64_t shutdown_cancels = 0;  // 因程序退出被取消（或被拒绝）的借出数
+    size_t in_flight = 0;           // 当前已借出的连接数
+};
+
+class CQueryWatchdog
+{
+public:
+    // 1、获取单例实例
+    static CQueryWatchdog &GetInstance()
+    {
+        static CQueryWatchdog instance;
+        return instance;
+    }
+
+    // 一次请求的截止时间范围，析构时恢复为不设截止时间（连接仍登记到归还为止）
+    class Scope
+    {
+    public:
+        // timeout 为 0 表示不设截止时间（仍会在程序退出时被取消）
+        Scope(CConnectionPool::Handle &handle, std::chrono::milliseconds timeout);
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+        // 本次借出是否已被看门狗取消（用于区分超时与其他错误）
+        bool Cancelled() const;
+
+    private:
+        CConnectionPool::Entry &entry_;
+    };
+
+    // 2、启动/停止看门狗线程；shutdown_flag 置位后取消全部在途查询
+    //    有已借出连接时每隔 shutdown_check 检查一次关闭标志，没有时不会醒来
+    void Start(const std::atomic<bool> *shutdown_flag,
+               std::chrono::milliseconds shutdown_check = std::chrono::milliseconds(50));
+    void Stop();
+
+    // 3、立即取消全部在途查询
+    void CancelAll();
+
+    // 4、登记/注销借出的连接（由 CConnectionPool 在借出和归还时调用）
+    //    正在退出时 Register 抛出 std::runtime_error；Unregister 返回借出期间是否发出过取消请求
+    void Register(CConnectionPool::Entry &entry);
+    bool Unregister(CConnectionPool::Entry &entry);
+
+    // 关闭标志是否已置位
+    bool ShuttingDown() const
+    {
+        const std::atomic<bool> *flag = shutdown_flag_.load();
+        return flag && flag->load();
+    }
+
+    WatchdogStats GetStats() const;
+
+    CQueryWatchdog(const CQueryWatchdog &) = delete;
+    CQueryWatchdog &operator=(const CQueryWatchdog &) = delete;
+
+private:
+    // 一次借出的状态
+    struct Checkout
+    {
+        pqxx::connection *conn = nullptr;
+        bool has_deadline = false;
+        std::chrono::steady_clock::time_point deadline;
+        bool cancelled = false;
+        bool cancelling = false; // 正在锁外发送取消请求，Unregister 须等待其结束
+    };
+
+    CQueryWatchdog() = default;
+    ~CQueryWatchdog();
+
+    // Scope 开始时设置截止时间（正在退出时返回 false），结束时清除
+    bool BeginScope(CConnectionPool::Entry &entry, std::chrono::milliseconds timeout);
+    void EndScope(CConnectionPool::Entry &entry);
+    bool Cancelled(CConnectionPool::Entry &entry) const;
+    // 调用者持有 mutex_：标记取消并加入 targets（已取消过的不再加入），返回是否新加入
+    static bool MarkCancelled(Checkout &checkout, std::vector<Checkout *> &targets);
+    // 在锁外逐个发送取消请求（cancel_query 需要新建连接往返，不阻塞借出和归还），然后清除 cancelling
+    void SendCancels(std::unique_lock<std::mutex> &lock, std::vector<Checkout *> &targets);
+    void Run();
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable cancel_cv_; // 锁外的取消请求发送完毕
+    std::unordered_map<CConnectionPool::Entry *, Checkout> checkouts_; // 已借出的连接
+    std::atomic<const std::atomic<bool> *> shutdown_flag_{nullptr};
+    std::chrono::milliseconds shutdown_check_{50};
+    bool running_ = false;
+    std::thread thread_;
+
+    uint64_t registered_ = 0;
+    uint64_t scopes_ = 0;
+    uint64_t deadline_cancels_ = 0;
+    uint64_t shutdown_cancels_ = 0;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+// 主库 + 只读副本的读写路由
+// 主库和每个副本各有一个 CConnectionPool；按要开启的事务类型选择连接池：
+//   - pqxx::work 等读写事务 -> 主库
+//   - pqxx::nontransaction / pqxx::read_transaction -> 未完成请求最少的副本
+// 没有配置副本，或副本全部不可用时，读请求回退到主库。
+// 副本借出连接失败（连接失败或借出超时）后暂停使用 retry_after，期间不再向其路由
+//
+// 注意：副本存在复制延迟，刚写入主库的数据需要立即读回时应使用 AcquireFor<pqxx::work>()
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <pqxx/pqxx>
+
+#include "CConnectionPool.h"
+
+// 路由目标
+enum class Route
+{
+    PRIMARY, // 主库
+    REPLICA  // 只读副本
+};
+
+// 事务类型 -> 路由目标，默认走主库
+template <typename TXN>
+struct RouteFor
+{
+    static constexpr Route value = Route::PRIMARY;
+};
+
+template <>
+struct RouteFor<pqxx::nontransaction>
+{
+    static constexpr Route value = Route::REPLICA;
+};
+
+template <>
+struct RouteFor<pqxx::read_transaction>
+{
+    static constexpr Route value = Route::REPLICA;
+};
+
+class CRoutedPool
+{
+public:
+    // primary: 主库连接池配置；replicas: 每个副本一个连接池配置（可以为空）
+    CRoutedPool(PoolOptions primary, std::vector<PoolOptions> replicas,
+                std::chrono::milliseconds retry_after = std::chrono::milliseconds(5000));
+
+    CRoutedPool(const CRoutedPool &) = delete;
+    CRoutedPool &operator=(const CRoutedPool &) = delete;
+
+    // 1、按路由目标借出连接
+    CConnectionPool::Handle Acquire(Route route = Route::PRIMARY);
+
+    // 2、按将要开启的事务类型借出连接，例如 AcquireFor<pqxx::read_transaction>()
+    template <typename TXN>
+    CConnectionPool::Handle AcquireFor() { return Acquire(RouteFor<TXN>::value); }
+
+    // 3、访问各连接池（统计、驱逐空闲连接等）
+    CConnectionPool &Primary() { return *primary_; }
+    size_t ReplicaCount() const { return replicas_.size(); }
+    CConnectionPool &Replica(size_t index) { return *replicas_[index]->pool; }
+
+    // 4、各目标的路由次数：下标 0 为主库，1..N 为副本
+    std::vector<uint64_t> GetRouteCounts() const;
+
+    // 5、输出各连接池统计到 g_logger
+    void LogStats() const;
+
+    // 6、并行预热主库和全部副本的空闲连接（见 CConnectionPool::Warmup）
+    //    没有连接通过的副本暂停使用；返回主库通过的连接数
+    int Warmup(const std::function<void(PooledConnection &)> &fn);
+
+    // 7、借出读连接并返回所选目标（0 为主库，1..N 为副本）；avoid 为需要避开的目标，-1 表示不限。
+    //    除 avoid 外没有可用副本时借出主库连接（avoid 为主库时即主库上的另一个连接）
+    CConnectionPool::Handle AcquireRead(int avoid, int &target);
+
+private:
+    struct ReplicaSlot
+    {
+        std::unique_ptr<CConnectionPool> pool;
+        std::string name;                     // 日志中显示的名称
+        std::atomic<int64_t> down_until{0};   // 暂停使用截止时间（steady_clock 纳秒），0 表示可用
+        std::atomic<uint64_t> routed{0};      // 路由到该副本的次数
+    };
+
+    // 按未完成请求数从少到多返回可用副本的下标
+    std::vector<size_t> RankReplicas() const;
+
+    std::unique_ptr<CConnectionPool> primary_;
+    std::vector<std::unique_ptr<ReplicaSlot>> replicas_;
+    std::chrono::milliseconds retry_after_;
+    std::atomic<uint64_t> primary_routed_{0};
+};
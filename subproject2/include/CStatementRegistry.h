@@ -0,0 +1,128 @@
+#pragma once
+
+// 预处理语句注册表
+// 程序启动时登记一份"语句名 -> SQL"目录，每个连接只准备一次（首次使用时或建立连接时），
+// 之后热点查询通过 exec(pqxx::prepped{...}) 执行，省去服务端重复的解析和计划开销。
+// 类型化查询（见 CTypedQuery.h）同样登记在这里，准备后立即按声明校验参数个数和结果列数；
+// 登记时为每个查询类型分配序号并缓存其指标，ExecTyped 按序号判断是否已准备，不做按名称的查找
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <pqxx/pqxx>
+
+#include "CConnectionPool.h"
+#include "CQueryMetrics.h"
+
+class CStatementRegistry
+{
+public:
+    // 1、获取单例实例
+    static CStatementRegistry &GetInstance()
+    {
+        static CStatementRegistry instance;
+        return instance;
+    }
+
+    // 准备后的校验函数（在准备所用连接上的事务中调用）：不通过时抛出异常，
+    // 服务端无法完成全部校验（如 PostgreSQL 16 之前无法校验结果列数）时返回 false
+    using Validator = bool (*)(pqxx::transaction_base &tx);
+
+    // 2、登记语句（同名语句会被覆盖，应在借出任何连接之前完成登记）
+    void Register(const std::string &name, const std::string &sql, Validator validate = nullptr);
+
+    // 登记类型化查询：语句名和 SQL 取自描述类型，准备后调用 Query::Validate
+    template <typename Query>
+    void RegisterTyped()
+    {
+        TypedSlot &slot = Slot<Query>();
+        slot.id = RegisterTyped(Query::name, Query::sql, &Query::Validate);
+        slot.metrics = &CQueryMetrics::GetInstance().Get(Query::name);
+    }
+
+    // 3、查询语句是否已登记
+    bool Contains(const std::string &name) const;
+
+    // 4、获取已登记语句的 SQL，未登记时抛出 std::out_of_range
+    std::string GetSql(const std::string &name) const;
+
+    // 5、确保语句已在该连接上准备（首次使用时准备）；连接上已有进行中的事务时传入该事务用于校验
+    void Ensure(CConnectionPool::Entry &entry, const std::string &name);
+    void Ensure(pqxx::transaction_base &txn, CConnectionPool::Entry &entry, const std::string &name);
+
+    // 6、在该连接上准备目录中的全部语句（建立连接时调用；校验未通过的语句记录错误后跳过）
+    void PrepareAll(CConnectionPool::Entry &entry);
+
+    // 7、执行预处理语句：未准备时先准备，再走 exec_prepared 快速路径（按语句名记录指标）
+    template <typename TXN>
+    pqxx::result Exec(TXN &txn, CConnectionPool::Entry &entry,
+                      const std::string &name, const pqxx::params &params = {})
+    {
+        Ensure(txn, entry, name);
+        return CQueryMetrics::GetInstance().Measure(name, [&]
+                                                    { return txn.exec(pqxx::prepped{name}, params); });
+    }
+
+    // 8、执行类型化查询（须已通过 RegisterTyped 登记），参数按 Query 声明的类型传入
+    template <typename Query, typename TXN, typename... A>
+    typename Query::Result ExecTyped(TXN &txn, CConnectionPool::Entry &entry, const A &...params)
+    {
+        const TypedSlot &slot = Slot<Query>();
+        if (!slot.metrics)
+            throw std::logic_error(std::string("未登记的类型化查询: ") + Query::name);
+
+        // 首次在该连接上使用时才按名称准备，之后只是一次 vector 下标访问
+        if (slot.id >= entry.typed_prepared.size() || !entry.typed_prepared[slot.id])
+            EnsureTyped(txn, entry, Query::name, slot.id);
+
+        return typename Query::Result(
+            CQueryMetrics::GetInstance().Measure(*slot.metrics, [&]
+                                                 { return txn.exec(pqxx::prepped{Query::name}, Query::Bind(params...)); }),
+            Query::name);
+    }
+
+    // 防止拷贝
+    CStatementRegistry(const CStatementRegistry &) = delete;
+    CStatementRegistry &operator=(const CStatementRegistry &) = delete;
+
+private:
+    CStatementRegistry() = default;
+    ~CStatementRegistry() = default;
+
+    static constexpr size_t NOT_TYPED = static_cast<size_t>(-1);
+
+    struct Statement
+    {
+        std::string sql;
+        Validator validate = nullptr;
+        size_t typed_id = NOT_TYPED; // 类型化查询的序号
+    };
+
+    // 每个类型化查询类型一个：序号和缓存的指标（登记在借出任何连接之前完成，之后只读）
+    struct TypedSlot
+    {
+        size_t id = NOT_TYPED;
+        StatementMetrics *metrics = nullptr;
+    };
+
+    template <typename Query>
+    static TypedSlot &Slot()
+    {
+        static TypedSlot slot;
+        return slot;
+    }
+
+    size_t RegisterTyped(const std::string &name, const std::string &sql, Validator validate);
+    void EnsureTyped(pqxx::transaction_base &txn, CConnectionPool::Entry &entry, const std::string &name,
+                     size_t id);
+    Statement Get(const std::string &name) const;
+    // 在连接上准备语句并校验（txn 为空时在独立的 nontransaction 中校验），校验失败时撤销准备
+    static void Prepare(CConnectionPool::Entry &entry, const std::string &name, const Statement &statement,
+                        pqxx::transaction_base *txn);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Statement> catalog_; // 语句名 -> SQL
+    size_t next_typed_id_ = 0;
+};
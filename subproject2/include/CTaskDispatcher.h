@@ -0,0 +1,117 @@
+#pragma once
+
+// LISTEN/NOTIFY 驱动的任务分发器
+// 一个分发线程持有专用连接 LISTEN 指定通道，在 await_notification 上阻塞等待；
+// 每收到一条通知就把 payload 交给待处理任务最少的工作线程，并只唤醒该线程。
+// 工作线程在各自的条件变量上无超时等待：没有任务时不会被唤醒，
+// 任务从通知到达到开始执行只需一次线程切换，不再受轮询间隔限制。
+//
+// 分发线程的 await_notification 超时只用于检查停止条件，不影响任务的响应速度
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pqxx/pqxx>
+
+#include "CLatencyHistogram.h"
+
+// 分发器配置
+struct DispatcherOptions
+{
+    std::string conn_str;                         // LISTEN 专用连接的连接字符串
+    std::string channel = "task_ready";           // 通知通道
+    int workers = 2;                              // 工作线程数
+    std::chrono::milliseconds listen_timeout{1000}; // 单次 await_notification 的最长阻塞时间
+    std::function<bool()> stop_when;              // 分发线程每次醒来时检查，返回 true 则停止（可为空）
+};
+
+// 分发统计
+struct DispatcherStats
+{
+    uint64_t notifications = 0;        // 收到的通知数
+    uint64_t completed = 0;            // 已执行完的任务数
+    uint64_t failed = 0;               // 执行时抛出异常的任务数
+    uint64_t reconnects = 0;           // LISTEN 连接重建次数
+    std::vector<uint64_t> per_worker;  // 各工作线程执行的任务数
+    double pickup_p50_ms = 0.0;        // 从收到通知到开始执行的延迟
+    double pickup_p99_ms = 0.0;
+    double pickup_max_ms = 0.0;
+};
+
+class CTaskDispatcher
+{
+public:
+    // 任务处理函数：worker_id 为工作线程编号，payload 为通知内容
+    using TaskFunc = std::function<void(int worker_id, const std::string &payload)>;
+
+    CTaskDispatcher(DispatcherOptions options, TaskFunc handler);
+    ~CTaskDispatcher();
+
+    CTaskDispatcher(const CTaskDispatcher &) = delete;
+    CTaskDispatcher &operator=(const CTaskDispatcher &) = delete;
+
+    // 1、启动工作线程和分发线程
+    void Start();
+
+    // 2、停止：不再接收通知，工作线程执行完已分配的任务后退出
+    void Stop();
+
+    // 3、阻塞直到分发器停止（Stop 被调用或 stop_when 返回 true）
+    void Wait();
+
+    // 4、不经数据库直接投递一个任务（与通知走相同的分配逻辑）
+    void Post(std::string payload);
+
+    DispatcherStats GetStats() const;
+
+private:
+    class Receiver; // LISTEN 通知接收者（pqxx::notification_receiver）
+
+    struct Task
+    {
+        std::string payload;
+        std::chrono::steady_clock::time_point received;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<Task> tasks;
+        std::atomic<int> pending{0};     // 已分配未完成的任务数（含正在执行的）
+        std::atomic<uint64_t> handled{0};
+        std::thread thread;
+    };
+
+    void ListenLoop();
+    void WorkerLoop(int id);
+    void Dispatch(Task task);
+    void Shutdown();
+
+    DispatcherOptions options_;
+    TaskFunc handler_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::thread listener_;
+
+    std::atomic<bool> started_{false};
+    std::atomic<bool> running_{false};  // 分发线程继续监听
+    std::atomic<bool> stopping_{false}; // 工作线程在取完任务后退出
+    std::atomic<size_t> next_worker_{0}; // 轮转起点，待处理数相同时均匀分配
+    std::mutex state_mutex_;
+    std::condition_variable done_cv_;
+    bool listener_done_ = false;
+
+    std::atomic<uint64_t> notifications_{0};
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint64_t> failed_{0};
+    std::atomic<uint64_t> reconnects_{0};
+    mutable CLatencyHistogram pickup_us_; // 取分位数需要快照，不改变计数
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+// users 行的进程内读穿透缓存
+// 按主键分片的 LRU，带 TTL 和内存预算；失效由数据库触发器发出的 NOTIFY 驱动：
+// 一个专用连接 LISTEN 指定通道，收到 UPDATE/DELETE 通知后删除对应 id 的缓存项。
+// 命中率和失效相关计数定期写入 g_logger
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <pqxx/pqxx>
+
+#include "CUserDao.h"
+
+// 缓存配置
+struct CacheOptions
+{
+    std::string conn_str;                             // LISTEN 专用连接的连接字符串
+    std::string channel = "users_changed";            // 通知通道
+    size_t shard_count = 16;                          // 分片数
+    size_t memory_budget = 64 * 1024 * 1024;          // 内存预算（字节，所有分片合计）
+    std::chrono::milliseconds ttl{60000};             // 缓存项有效期
+    std::chrono::seconds report_interval{60};         // 统计日志输出间隔，0 表示不输出
+};
+
+// 缓存统计
+struct CacheStats
+{
+    uint64_t hits = 0;            // 命中次数
+    uint64_t misses = 0;          // 未命中次数（含过期）
+    uint64_t expired = 0;         // 因 TTL 过期而未命中的次数
+    uint64_t evictions = 0;       // 因内存预算淘汰的项数
+    uint64_t invalidations = 0;   // 收到的失效通知数
+    uint64_t stale_discarded = 0; // 加载期间发生失效、未写入缓存的加载结果数
+    uint64_t resyncs = 0;         // LISTEN 连接重建导致的整体清空次数
+    size_t entries = 0;           // 当前缓存项数
+    size_t bytes = 0;             // 当前估算内存占用
+
+    double HitRate() const { return hits + misses ? double(hits) / double(hits + misses) : 0.0; }
+};
+
+class CUserCache
+{
+public:
+    // 缓存未命中时调用的加载函数：返回 std::nullopt 表示该 id 不存在（不缓存）
+    using LoadFunc = std::function<std::optional<UserRecord>(int id)>;
+
+    CUserCache(CacheOptions options, LoadFunc load);
+    ~CUserCache();
+
+    CUserCache(const CUserCache &) = delete;
+    CUserCache &operator=(const CUserCache &) = delete;
+
+    // 1、读穿透：命中直接返回，未命中时调用加载函数并写入缓存
+    std::optional<UserRecord> Get(int id);
+
+    // 2、删除指定 id 的缓存项
+    void Invalidate(int id);
+
+    // 3、清空全部缓存
+    void Clear();
+
+    // 4、启动/停止 LISTEN 线程
+    void Start();
+    void Stop();
+
+    CacheStats GetStats() const;
+    void LogStats() const;
+
+    // 5、在 users 表上安装 UPDATE/DELETE 时发出 NOTIFY 的触发器（payload 为旧行 id）
+    static void InstallTrigger(pqxx::connection &conn, const std::string &channel);
+
+private:
+    class Receiver; // LISTEN 通知接收者（pqxx::notification_receiver）
+
+    struct Node
+    {
+        int id;
+        UserRecord value;
+        size_t bytes;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::list<Node> lru; // 队首为最近使用
+        std::unordered_map<int, std::list<Node>::iterator> index;
+        size_t bytes = 0;
+        uint64_t epoch = 0; // 每次失效递增，用于识别加载期间发生的失效
+    };
+
+    Shard &ShardFor(int id) { return *shards_[static_cast<size_t>(id) % shards_.size()]; }
+    static size_t EstimateBytes(const UserRecord &value);
+    void EraseLocked(Shard &shard, std::list<Node>::iterator it);
+    void ListenLoop();
+    void OnNotification(const std::string &payload);
+
+    CacheOptions options_;
+    LoadFunc load_;
+    size_t shard_budget_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> expired_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> invalidations_{0};
+    std::atomic<uint64_t> stale_discarded_{0};
+    std::atomic<uint64_t> resyncs_{0};
+
+    std::atomic<bool> running_{false};
+    std::thread listener_;
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+// users 表的数据访问封装
+// 单键查询走预处理语句，批量查询通过 pqxx::pipeline 一次性发送，
+// 使吞吐量取决于服务端 CPU 而不是网络往返时间
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <pqxx/pqxx>
+
+#include "CConnectionPool.h"
+#include "CRowMapper.h"
+#include "CTypedQuery.h"
+
+// users 表的一行；字符串字段指向 pqxx::result 的缓冲区，只在 result 存活期间有效
+struct User
+{
+    int id = 0;
+    std::string_view username;
+    std::string_view full_name;
+    std::string_view email;
+    std::string_view phone;
+};
+
+// users 表的一行（自有存储），用于需要脱离 pqxx::result 保存的场景，如缓存
+struct UserRecord
+{
+    int id = 0;
+    std::string username;
+    std::string full_name;
+    std::string email;
+    std::string phone;
+
+    UserRecord() = default;
+    explicit UserRecord(const User &user)
+        : id(user.id), username(user.username), full_name(user.full_name),
+          email(user.email), phone(user.phone) {}
+};
+
+template <>
+struct RowMapping<User>
+{
+    static constexpr auto columns = std::make_tuple(
+        MapColumn("id", &User::id),
+        MapColumn("username", &User::username),
+        MapColumn("full_name", &User::full_name),
+        MapColumn("email", &User::email),
+        MapColumn("phone", &User::phone));
+};
+
+// 按 id 查询用户名和邮箱（类型化查询：参数和结果列的类型在编译期确定）
+struct FindUserBrief : TypedQuery<FindUserBrief, Params<int>, Row<int, std::string_view, std::string_view>>
+{
+    static constexpr const char *name = "find_user_brief";
+    static constexpr const char *sql = "SELECT id, username, email FROM users WHERE id = $1";
+};
+
+class CUserDao
+{
+public:
+    static constexpr const char *STMT_FIND_BY_ID = "find_user_by_id";
+    static constexpr const char *STMT_FIND_BY_ID_LIST = "find_users_by_id_list";
+
+    // 1、登记 users 相关的预处理语句
+    static void RegisterStatements();
+
+    // 2、按 id 查询单个用户（预处理语句，单次往返）
+    static pqxx::result FindById(CConnectionPool::Handle &handle, int id);
+
+    // 3、批量按 id 查询：所有查询经 pipeline 发送，结果与 ids 顺序一一对应
+    //    每个结果包含 0 行（不存在）或 1 行
+    static std::vector<pqxx::result> FindByIds(CConnectionPool::Handle &handle,
+                                               const std::vector<int> &ids);
+
+    // 4、一条 WHERE id = ANY($1) 查询取回多个用户，行顺序不确定，不存在的 id 没有对应行
+    static pqxx::result FindByIdList(CConnectionPool::Handle &handle, const std::vector<int> &ids);
+
+    // 5、按 id 查询用户简要信息（类型化查询，经 CStatementRegistry 准备、校验并记录指标）
+    static FindUserBrief::Result FindBriefById(CConnectionPool::Handle &handle, int id);
+};
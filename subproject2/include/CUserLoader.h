@@ -0,0 +1,71 @@
+#pragma once
+
+// users 单键查询的请求合并层（dataloader）
+// 在一个很短的时间窗口内（或凑满 max_batch 个 id 时）收集多个线程请求的 id，
+// 只发送一条 WHERE id = ANY($1) 查询，再把结果行分发给各个等待的调用者。
+// 突发负载下 N 次往返变为 1 次，调用方式仍然是"传入一个 id，返回一行"。
+// 设置 CBatchController 后，时间窗口和 max_batch 按每批查询的耗时自动调整
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <pqxx/pqxx>
+
+#include "CBatchController.h"
+#include "CRoutedPool.h"
+
+// 合并统计
+struct LoaderStats
+{
+    uint64_t loads = 0;   // Load 调用次数
+    uint64_t batches = 0; // 实际发出的查询次数
+    uint64_t keys = 0;    // 查询的去重后 id 总数
+};
+
+class CUserLoader
+{
+public:
+    // window: 第一个请求到达后等待更多请求的时长；max_batch: 单次查询的最大 id 数
+    CUserLoader(CRoutedPool &pool, std::chrono::microseconds window, size_t max_batch);
+
+    CUserLoader(const CUserLoader &) = delete;
+    CUserLoader &operator=(const CUserLoader &) = delete;
+
+    // 按 id 加载用户；不存在时返回 std::nullopt，查询失败时抛出异常
+    // 返回的 pqxx::row 持有所在 result 的引用，可直接交给 CRowMapper<User>::Map
+    std::optional<pqxx::row> Load(int id);
+
+    LoaderStats GetStats() const;
+
+    // 由控制器调整时间窗口和 max_batch（控制器须比加载器存活更久，传 nullptr 取消）
+    void SetController(CBatchController *controller);
+
+private:
+    // 一个合并批次：第一个加入的线程为领导者，负责执行查询
+    struct Batch
+    {
+        std::vector<int> keys;
+        std::unordered_map<int, pqxx::row> rows;
+        std::exception_ptr error;
+        bool sealed = false; // 不再接受新 id
+        bool done = false;   // 查询已完成
+        std::condition_variable cv;
+    };
+
+    void Execute(Batch &batch, CBatchController *controller);
+
+    CRoutedPool &pool_;
+    std::chrono::microseconds window_;
+    size_t max_batch_;
+    CBatchController *controller_ = nullptr;
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<Batch> current_; // 正在收集 id 的批次
+    LoaderStats stats_;
+};
@@ -0,0 +1,452 @@
+#include "CAsyncQueryEngine.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "CQueryMetrics.h"
+
+namespace
+{
+// 结果中全部字段的字节数（同 CQueryMetrics::ResultBytes）
+size_t ResultBytes(const CPgResult &result)
+{
+    if (!result)
+        return 0;
+    size_t bytes = 0;
+    for (int row = 0; row < result.Rows(); ++row)
+    {
+        for (int col = 0; col < result.Columns(); ++col)
+            bytes += static_cast<size_t>(result.Length(row, col));
+    }
+    return bytes;
+}
+} // namespace
+
+CAsyncQueryEngine::CAsyncQueryEngine(const std::string &conn_str, int connection_count,
+                                     std::string metrics_name)
+    : metrics_name_(std::move(metrics_name))
+{
+    if (connection_count < 1)
+        connection_count = 1;
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || event_fd_ < 0)
+    {
+        if (epoll_fd_ >= 0)
+            close(epoll_fd_);
+        if (event_fd_ >= 0)
+            close(event_fd_);
+        throw std::runtime_error("创建 epoll/eventfd 失败");
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = UINT64_MAX; // 约定 UINT64_MAX 表示 eventfd
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd_, &ev);
+
+    try
+    {
+        // 建立连接并切换为非阻塞模式，socket 注册到 epoll（data 中保存连接下标）
+        slots_.resize(connection_count);
+        for (int i = 0; i < connection_count; ++i)
+        {
+            Slot &slot = slots_[i];
+            slot.conn = std::make_unique<CPgConn>(conn_str);
+            if (PQsetnonblocking(slot.conn->Raw(), 1) != 0)
+                throw std::runtime_error("设置非阻塞模式失败");
+            slot.fd = PQsocket(slot.conn->Raw());
+
+            epoll_event slot_ev{};
+            slot_ev.events = EPOLLIN;
+            slot_ev.data.u64 = static_cast<uint64_t>(i);
+            if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, slot.fd, &slot_ev) != 0)
+                throw std::runtime_error("注册连接 socket 到 epoll 失败");
+
+            idle_.push_back(static_cast<size_t>(i));
+        }
+        alive_count_ = slots_.size();
+    }
+    catch (...)
+    {
+        slots_.clear();
+        close(epoll_fd_);
+        close(event_fd_);
+        throw;
+    }
+
+    loop_ = std::thread(&CAsyncQueryEngine::Run, this);
+}
+
+CAsyncQueryEngine::~CAsyncQueryEngine()
+{
+    Stop();
+    close(epoll_fd_);
+    close(event_fd_);
+}
+
+void CAsyncQueryEngine::Submit(std::string sql, Params params, Callback callback,
+                               CPgConn::ResultFormat format)
+{
+    auto request = std::make_unique<Request>();
+    request->sql = std::move(sql);
+    request->params = std::move(params);
+    request->format = format;
+    request->callback = std::move(callback);
+
+    {
+        // 与 Stop 在同一把锁下检查 stop_：否则检查通过后 Stop 恰好取走 pending_，
+        // 随后放入的请求既不会被执行也不会以异常结束
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stop_)
+        {
+            pending_.push_back(std::move(request));
+        }
+    }
+    if (request)
+    {
+        Fail(std::move(request), "异步查询引擎已停止");
+        return;
+    }
+    Wakeup();
+}
+
+std::future<CPgResult> CAsyncQueryEngine::Submit(std::string sql, Params params,
+                                                 CPgConn::ResultFormat format)
+{
+    auto promise = std::make_shared<std::promise<CPgResult>>();
+    std::future<CPgResult> future = promise->get_future();
+    Submit(
+        std::move(sql), std::move(params),
+        [promise](CPgResult result, std::exception_ptr error)
+        {
+            if (error)
+                promise->set_exception(error);
+            else
+                promise->set_value(std::move(result));
+        },
+        format);
+    return future;
+}
+
+void CAsyncQueryEngine::Stop()
+{
+    // 在 mutex_ 下设置 stop_ 并取走排队中的请求，此后 Submit 不会再放入新请求
+    std::deque<std::unique_ptr<Request>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_.exchange(true))
+            return;
+        pending.swap(pending_);
+    }
+    Wakeup();
+    if (loop_.joinable())
+        loop_.join();
+
+    // 事件循环已退出（退出前已取消在途查询）：在途和排队中的请求全部以异常结束
+    for (size_t i = 0; i < slots_.size(); ++i)
+    {
+        if (slots_[i].request)
+        {
+            --in_flight_;
+            RecordError(*slots_[i].request);
+            Fail(std::move(slots_[i].request), "异步查询引擎已停止");
+        }
+    }
+    for (auto &request : pending)
+    {
+        Fail(std::move(request), "异步查询引擎已停止");
+    }
+}
+
+size_t CAsyncQueryEngine::Pending() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+}
+
+void CAsyncQueryEngine::Wakeup()
+{
+    uint64_t one = 1;
+    ssize_t n = write(event_fd_, &one, sizeof(one));
+    (void)n; // 计数器溢出时写入失败也无妨，事件循环已处于待唤醒状态
+}
+
+void CAsyncQueryEngine::Run()
+{
+    std::vector<epoll_event> events(slots_.size() + 1);
+
+    while (!stop_)
+    {
+        int n = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), -1);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        for (int i = 0; i < n; ++i)
+        {
+            const epoll_event &ev = events[i];
+            if (ev.data.u64 == UINT64_MAX)
+            {
+                uint64_t value;
+                while (read(event_fd_, &value, sizeof(value)) > 0)
+                {
+                }
+                continue;
+            }
+
+            size_t index = static_cast<size_t>(ev.data.u64);
+            if (!slots_[index].alive)
+                continue;
+            if (ev.events & EPOLLOUT)
+                OnWritable(index);
+            if (slots_[index].alive && (ev.events & (EPOLLIN | EPOLLERR | EPOLLHUP)))
+                OnReadable(index);
+        }
+
+        // 把排队中的请求分配给空闲连接
+        Dispatch();
+    }
+
+    // 停止时（Stop 等待本线程结束之前）取消仍在执行的查询，服务端不必再把它们执行完
+    CancelBusy();
+}
+
+void CAsyncQueryEngine::CancelBusy()
+{
+    for (Slot &slot : slots_)
+    {
+        if (!slot.alive || !slot.request)
+            continue;
+        PGcancel *cancel = PQgetCancel(slot.conn->Raw());
+        if (!cancel)
+            continue;
+        char error[256];
+        PQcancel(cancel, error, sizeof(error)); // 失败时连接随引擎析构关闭，服务端同样会中止查询
+        PQfreeCancel(cancel);
+    }
+}
+
+void CAsyncQueryEngine::Dispatch()
+{
+    // 所有连接都已损坏时，排队中的请求不可能再被执行
+    if (alive_count_ == 0)
+    {
+        std::deque<std::unique_ptr<Request>> pending;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending.swap(pending_);
+        }
+        for (auto &request : pending)
+        {
+            Fail(std::move(request), "异步查询引擎没有可用连接");
+        }
+        return;
+    }
+
+    while (!idle_.empty())
+    {
+        size_t index = idle_.back();
+        if (!slots_[index].alive)
+        {
+            idle_.pop_back();
+            continue;
+        }
+
+        std::unique_ptr<Request> request;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_.empty())
+                return;
+            request = std::move(pending_.front());
+            pending_.pop_front();
+        }
+
+        idle_.pop_back();
+        slots_[index].request = std::move(request);
+        ++in_flight_;
+        Send(index);
+    }
+}
+
+bool CAsyncQueryEngine::Send(size_t index)
+{
+    Slot &slot = slots_[index];
+    const Request &request = *slot.request;
+
+    std::vector<const char *> values;
+    values.reserve(request.params.size());
+    for (const auto &param : request.params)
+    {
+        values.push_back(param ? param->c_str() : nullptr);
+    }
+
+    slot.result = CPgResult();
+    slot.error.clear();
+    slot.request->start = std::chrono::steady_clock::now();
+
+    if (!PQsendQueryParams(slot.conn->Raw(), request.sql.c_str(), static_cast<int>(values.size()),
+                           nullptr, values.data(), nullptr, nullptr, request.format))
+    {
+        KillSlot(index, PQerrorMessage(slot.conn->Raw()));
+        return false;
+    }
+
+    // 非阻塞模式下查询可能尚未完全写出，剩余部分在 socket 可写时继续发送
+    int flushed = PQflush(slot.conn->Raw());
+    if (flushed < 0)
+    {
+        KillSlot(index, PQerrorMessage(slot.conn->Raw()));
+        return false;
+    }
+    slot.want_write = (flushed == 1);
+    UpdateEvents(slot);
+    return true;
+}
+
+void CAsyncQueryEngine::OnWritable(size_t index)
+{
+    Slot &slot = slots_[index];
+    int flushed = PQflush(slot.conn->Raw());
+    if (flushed < 0)
+    {
+        KillSlot(index, PQerrorMessage(slot.conn->Raw()));
+        return;
+    }
+    if (slot.want_write != (flushed == 1))
+    {
+        slot.want_write = (flushed == 1);
+        UpdateEvents(slot);
+    }
+}
+
+void CAsyncQueryEngine::OnReadable(size_t index)
+{
+    Slot &slot = slots_[index];
+    PGconn *conn = slot.conn->Raw();
+
+    if (!PQconsumeInput(conn))
+    {
+        KillSlot(index, PQerrorMessage(conn));
+        return;
+    }
+
+    // 空闲连接上的可读事件（如服务端通知）只需消费输入
+    if (!slot.request)
+        return;
+
+    // 取出所有已到达的结果，直到 PQgetResult 返回 nullptr 表示该请求完成
+    while (!PQisBusy(conn))
+    {
+        PGresult *raw = PQgetResult(conn);
+        if (!raw)
+        {
+            Finish(index);
+            return;
+        }
+
+        CPgResult result(raw);
+        ExecStatusType status = PQresultStatus(raw);
+        if (status == PGRES_TUPLES_OK || status == PGRES_COMMAND_OK)
+        {
+            slot.result = std::move(result);
+        }
+        else if (slot.error.empty())
+        {
+            slot.error = PQresultErrorMessage(raw);
+        }
+    }
+}
+
+void CAsyncQueryEngine::Finish(size_t index)
+{
+    Slot &slot = slots_[index];
+    std::unique_ptr<Request> request = std::move(slot.request);
+    CPgResult result = std::move(slot.result);
+    std::string error = std::move(slot.error);
+
+    idle_.push_back(index);
+    --in_flight_;
+    ++completed_;
+
+    if (!error.empty())
+    {
+        RecordError(*request);
+        std::string message = "执行失败 [" + request->sql + "]: " + error;
+        Fail(std::move(request), message);
+        return;
+    }
+
+    auto &metrics = CQueryMetrics::GetInstance();
+    if (metrics.Enabled())
+    {
+        metrics.Record(metrics_name_, std::chrono::steady_clock::now() - request->start,
+                       result ? static_cast<size_t>(result.Rows()) : 0, ResultBytes(result));
+    }
+    if (request->callback)
+    {
+        try
+        {
+            request->callback(std::move(result), nullptr);
+        }
+        catch (...)
+        {
+            // 回调中的异常不能影响事件循环
+        }
+    }
+}
+
+void CAsyncQueryEngine::Fail(std::unique_ptr<Request> request, const std::string &message)
+{
+    if (!request || !request->callback)
+        return;
+    try
+    {
+        request->callback(CPgResult(), std::make_exception_ptr(std::runtime_error(message)));
+    }
+    catch (...)
+    {
+    }
+}
+
+void CAsyncQueryEngine::UpdateEvents(Slot &slot)
+{
+    epoll_event ev{};
+    ev.events = static_cast<uint32_t>(EPOLLIN) | (slot.want_write ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    ev.data.u64 = static_cast<uint64_t>(&slot - slots_.data());
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, slot.fd, &ev);
+}
+
+void CAsyncQueryEngine::KillSlot(size_t index, const std::string &message)
+{
+    // 连接已损坏：从 epoll 移除，不再分配请求
+    Slot &slot = slots_[index];
+    if (!slot.alive)
+        return;
+    slot.alive = false;
+    --alive_count_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, slot.fd, nullptr);
+
+    if (slot.request)
+    {
+        --in_flight_;
+        ++completed_;
+        RecordError(*slot.request);
+        Fail(std::move(slot.request), "连接异常: " + message);
+    }
+}
+
+void CAsyncQueryEngine::RecordError(const Request &request)
+{
+    // 尚未发出（start 未设置）的请求不计入
+    if (request.start == std::chrono::steady_clock::time_point() || !CQueryMetrics::GetInstance().Enabled())
+        return;
+    CQueryMetrics::GetInstance().RecordError(metrics_name_, std::chrono::steady_clock::now() - request.start);
+}
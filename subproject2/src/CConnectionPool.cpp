@@ -0,0 +1,267 @@
+#include "CConnectionPool.h"
+
+#include <exception>
+#include <future>
+#include <stdexcept>
+
+#include "CQueryWatchdog.h"
+
+CConnectionPool::CConnectionPool(PoolOptions options)
+    : options_(std::move(options))
+{
+    // 保证参数合法：至少 1 个连接，且 min_size 不超过 max_size
+    if (options_.max_size < 1)
+        options_.max_size = 1;
+    if (options_.min_size < 0)
+        options_.min_size = 0;
+    if (options_.min_size > options_.max_size)
+        options_.min_size = options_.max_size;
+
+    // 并行预先建立 min_size 个连接：启动耗时约为建立一个连接的时间，而不是 min_size 倍
+    std::vector<std::future<std::unique_ptr<Entry>>> pending;
+    pending.reserve(options_.min_size);
+    for (int i = 0; i < options_.min_size; ++i)
+    {
+        pending.push_back(std::async(std::launch::async, [this]
+                                     { return CreateEntry(); }));
+    }
+
+    // 等待全部完成后再抛出第一个错误，避免后台线程仍在使用 this
+    std::exception_ptr error;
+    for (auto &future : pending)
+    {
+        try
+        {
+            auto entry = future.get();
+            entry->last_used = std::chrono::steady_clock::now();
+            idle_.push_back(std::move(entry));
+            ++total_;
+        }
+        catch (...)
+        {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+CConnectionPool::~CConnectionPool()
+{
+    // 析构前所有句柄都应已归还，这里只需关闭空闲连接
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_.clear();
+}
+
+std::unique_ptr<CConnectionPool::Entry> CConnectionPool::CreateEntry()
+{
+    auto entry = std::make_unique<Entry>();
+    entry->conn = std::make_unique<pqxx::connection>(options_.conn_str);
+    if (options_.on_connect)
+    {
+        options_.on_connect(*entry);
+    }
+    return entry;
+}
+
+CConnectionPool::Handle CConnectionPool::Acquire()
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + options_.checkout_timeout;
+
+    std::unique_ptr<Entry> entry;
+    std::vector<std::unique_ptr<Entry>> evicted; // 在锁外关闭，避免阻塞其他线程
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    EvictIdleLocked(evicted);
+
+    while (!entry)
+    {
+        // 1、优先复用最近归还的空闲连接（LIFO，让久未使用的连接自然过期）
+        if (!idle_.empty())
+        {
+            entry = std::move(idle_.back());
+            idle_.pop_back();
+            break;
+        }
+
+        // 2、未达到上限则新建连接（建立连接耗时较长，在锁外进行）
+        if (total_ < options_.max_size)
+        {
+            ++total_;
+            lock.unlock();
+            try
+            {
+                entry = CreateEntry();
+            }
+            catch (...)
+            {
+                lock.lock();
+                --total_;
+                cv_.notify_one();
+                throw;
+            }
+            lock.lock();
+            break;
+        }
+
+        // 3、等待其他线程归还连接
+        ++waiting_;
+        bool available = cv_.wait_until(lock, deadline, [this]
+                                        { return !idle_.empty() || total_ < options_.max_size; });
+        --waiting_;
+        if (!available)
+        {
+            ++timeouts_;
+            throw std::runtime_error("连接池借出超时 (" +
+                                     std::to_string(options_.checkout_timeout.count()) + " ms)");
+        }
+    }
+
+    // 更新统计信息
+    double wait_ms = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    ++in_use_;
+    ++checkouts_;
+    total_wait_ms_ += wait_ms;
+    if (wait_ms > max_wait_ms_)
+        max_wait_ms_ = wait_ms;
+
+    // 借出期间登记到看门狗（不设截止时间，由 CQueryWatchdog::Scope 按请求设置），退出时可被取消；
+    // 正在退出时抛出异常，句柄析构把连接放回连接池
+    Handle handle(this, std::move(entry));
+    lock.unlock();
+    CQueryWatchdog::GetInstance().Register(handle.GetEntry());
+    return handle;
+}
+
+int CConnectionPool::Warmup(const std::function<void(Entry &)> &fn)
+{
+    // 1、取出全部空闲连接（预热期间计为借出）
+    std::vector<std::unique_ptr<Entry>> entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!idle_.empty())
+        {
+            entries.push_back(std::move(idle_.back()));
+            idle_.pop_back();
+        }
+        in_use_ += static_cast<int>(entries.size());
+    }
+
+    // 2、并行执行，每个连接一个线程
+    std::vector<std::future<bool>> results;
+    results.reserve(entries.size());
+    for (auto &entry : entries)
+    {
+        results.push_back(std::async(std::launch::async, [&fn, &entry]
+                                     {
+            try
+            {
+                fn(*entry);
+                return entry->conn->is_open();
+            }
+            catch (const std::exception &)
+            {
+                return false;
+            } }));
+    }
+
+    // 3、通过的连接放回空闲队列，失败的连接关闭（先等待全部完成，不在锁内等待）
+    std::vector<bool> passed;
+    passed.reserve(results.size());
+    for (auto &result : results)
+        passed.push_back(result.get());
+
+    int healthy = 0;
+    std::vector<std::unique_ptr<Entry>> broken;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            --in_use_;
+            if (passed[i])
+            {
+                ++healthy;
+                entries[i]->last_used = std::chrono::steady_clock::now();
+                idle_.push_back(std::move(entries[i]));
+            }
+            else
+            {
+                --total_;
+                broken.push_back(std::move(entries[i]));
+            }
+        }
+    }
+    cv_.notify_all();
+    return healthy;
+}
+
+void CConnectionPool::Release(std::unique_ptr<Entry> entry, bool broken)
+{
+    // 借出期间发出过取消请求的连接直接关闭：取消请求可能在查询结束后才到达，会误伤下一个借出者
+    if (CQueryWatchdog::GetInstance().Unregister(*entry))
+        broken = true;
+
+    std::vector<std::unique_ptr<Entry>> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --in_use_;
+        if (broken || !entry->conn || !entry->conn->is_open())
+        {
+            // 损坏的连接直接丢弃，空出的名额可由等待者重新建立
+            --total_;
+            evicted.push_back(std::move(entry));
+        }
+        else
+        {
+            entry->last_used = std::chrono::steady_clock::now();
+            idle_.push_back(std::move(entry));
+        }
+        EvictIdleLocked(evicted);
+    }
+    cv_.notify_one();
+}
+
+void CConnectionPool::EvictIdle()
+{
+    std::vector<std::unique_ptr<Entry>> evicted;
+    std::lock_guard<std::mutex> lock(mutex_);
+    EvictIdleLocked(evicted);
+}
+
+void CConnectionPool::EvictIdleLocked(std::vector<std::unique_ptr<Entry>> &evicted)
+{
+    // 队首是最早归还的连接
+    const auto now = std::chrono::steady_clock::now();
+    while (total_ > options_.min_size && !idle_.empty() &&
+           now - idle_.front()->last_used > options_.idle_timeout)
+    {
+        evicted.push_back(std::move(idle_.front()));
+        idle_.pop_front();
+        --total_;
+    }
+}
+
+PoolStats CConnectionPool::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    PoolStats stats;
+    stats.total = total_;
+    stats.in_use = in_use_;
+    stats.idle = static_cast<int>(idle_.size());
+    stats.waiting = waiting_;
+    stats.checkouts = checkouts_;
+    stats.timeouts = timeouts_;
+    stats.avg_wait_ms = checkouts_ ? total_wait_ms_ / checkouts_ : 0.0;
+    stats.max_wait_ms = max_wait_ms_;
+    return stats;
+}
+
+int CConnectionPool::Outstanding() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_use_ + waiting_;
+}
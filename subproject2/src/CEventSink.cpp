@@ -0,0 +1,233 @@
+#include "CEventSink.h"
+
+#include <cstdio>
+#include <ctime>
+#include <utility>
+#include "spdlog/spdlog.h"
+
+#include "CBulkWriter.h"
+#include "CQueryMetrics.h"
+
+extern std::shared_ptr<spdlog::logger> g_logger;
+
+namespace
+{
+thread_local bool t_writer_thread = false;
+
+// 格式化为 PostgreSQL 可直接解析的 UTC 时间：2024-01-02 03:04:05.678901+00
+std::string FormatTimestamp(std::chrono::system_clock::time_point time)
+{
+    const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+    std::time_t seconds = static_cast<std::time_t>(micros / 1000000);
+    long fraction = static_cast<long>(micros % 1000000);
+    if (fraction < 0)
+    {
+        fraction += 1000000;
+        --seconds;
+    }
+
+    std::tm tm{};
+    gmtime_r(&seconds, &tm);
+    char buffer[40];
+    int n = std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d %02d:%02d:%02d.%06ld+00",
+                          tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+                          fraction);
+    return std::string(buffer, n > 0 ? static_cast<size_t>(n) : 0);
+}
+} // namespace
+
+CEventSink::CEventSink(EventSinkOptions options)
+    : options_(std::move(options)), queue_(options_.capacity),
+      columns_(bulk_detail::JoinColumns({"ts", "kind", "level", "source", "payload"})),
+      metrics_name_("copy:" + options_.table)
+{
+    if (options_.flush_rows == 0)
+        options_.flush_rows = 1;
+}
+
+CEventSink::~CEventSink()
+{
+    Stop();
+}
+
+void CEventSink::CreateTable(pqxx::connection &conn, const std::string &table)
+{
+    pqxx::work tx(conn);
+    tx.exec("CREATE TABLE IF NOT EXISTS " + table +
+            " (ts timestamptz NOT NULL, kind text NOT NULL, level text NOT NULL,"
+            " source text NOT NULL DEFAULT '', payload text)");
+    tx.commit();
+}
+
+void CEventSink::Start()
+{
+    if (writer_.joinable())
+        return;
+    writer_ = std::thread(&CEventSink::Run, this);
+}
+
+void CEventSink::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex_);
+        stopping_ = true;
+    }
+    stop_cv_.notify_all();
+    queue_.Close();
+    if (writer_.joinable())
+        writer_.join();
+}
+
+bool CEventSink::Emit(std::string kind, std::string payload, std::string level, std::string source)
+{
+    EventRecord record;
+    record.time = std::chrono::system_clock::now();
+    record.kind = std::move(kind);
+    record.level = std::move(level);
+    record.source = std::move(source);
+    record.payload = std::move(payload);
+    return Emit(std::move(record));
+}
+
+bool CEventSink::Emit(EventRecord record)
+{
+    return Push(std::move(record), options_.policy);
+}
+
+bool CEventSink::EmitLog(EventRecord record)
+{
+    const OverflowPolicy policy =
+        options_.log_policy == OverflowPolicy::BLOCK ? OverflowPolicy::OVERRUN_OLDEST : options_.log_policy;
+    return Push(std::move(record), policy);
+}
+
+bool CEventSink::Push(EventRecord record, OverflowPolicy policy)
+{
+    ++emitted_;
+    bool overran = false;
+    bool accepted = queue_.Push(std::move(record), policy, overran);
+    if (overran)
+        ++overrun_;
+    if (!accepted)
+        ++discarded_;
+    return accepted;
+}
+
+bool CEventSink::InWriterThread()
+{
+    return t_writer_thread;
+}
+
+void CEventSink::Run()
+{
+    t_writer_thread = true;
+
+    std::vector<EventRecord> batch;
+    batch.reserve(options_.flush_rows);
+    while (true)
+    {
+        // 1、等待本批第一条记录；队列已关闭且取完时退出
+        std::optional<EventRecord> first = queue_.Pop();
+        if (!first)
+            break;
+        batch.push_back(std::move(*first));
+
+        // 2、凑满 flush_rows 条或等到 flush_interval 为止
+        auto deadline = std::chrono::steady_clock::now() + options_.flush_interval;
+        while (batch.size() < options_.flush_rows &&
+               queue_.PopMany(batch, options_.flush_rows - batch.size(), deadline) > 0)
+        {
+        }
+
+        if (!WriteWithRetry(batch))
+        {
+            // 3、停止后仍写入失败：剩余记录不再逐批尝试连接，直接丢弃
+            size_t rest = 0;
+            while (queue_.Pop())
+                ++rest;
+            dropped_ += batch.size() + rest;
+            g_logger->error("事件写入器已停止，丢弃 {} 条未写入的记录", batch.size() + rest);
+            break;
+        }
+        batch.clear();
+    }
+    conn_.reset();
+}
+
+bool CEventSink::WriteWithRetry(const std::vector<EventRecord> &batch)
+{
+    while (true)
+    {
+        try
+        {
+            Write(batch);
+            written_ += batch.size();
+            ++flushes_;
+            return true;
+        }
+        catch (const std::exception &e)
+        {
+            ++failures_;
+            conn_.reset(); // 下次重试时重新连接
+            g_logger->warn("事件表写入失败 ({} 条): {}", batch.size(), e.what());
+        }
+
+        // 停止后不再等待重试
+        std::unique_lock<std::mutex> lock(stop_mutex_);
+        if (stop_cv_.wait_for(lock, options_.retry_interval, [this]
+                              { return stopping_; }))
+            return false;
+    }
+}
+
+void CEventSink::Write(const std::vector<EventRecord> &batch)
+{
+    std::string data;
+    for (const auto &record : batch)
+    {
+        bulk_detail::AppendLine(data, FormatTimestamp(record.time), record.kind, record.level, record.source,
+                                record.payload);
+    }
+
+    // 行数和字节数为本批记录数和 COPY 数据量
+    auto &metrics = CQueryMetrics::GetInstance();
+    auto start = std::chrono::steady_clock::now();
+    try
+    {
+        pqxx::work tx(Conn());
+        bulk_detail::CopyLines(tx, options_.table, columns_, data);
+        tx.commit();
+    }
+    catch (...)
+    {
+        metrics.RecordError(metrics_name_, std::chrono::steady_clock::now() - start);
+        throw;
+    }
+    metrics.Record(metrics_name_, std::chrono::steady_clock::now() - start, batch.size(), data.size());
+}
+
+pqxx::connection &CEventSink::Conn()
+{
+    if (!conn_ || !conn_->is_open())
+    {
+        conn_.reset();
+        conn_ = std::make_unique<pqxx::connection>(options_.conn_str);
+        if (options_.statement_timeout.count() > 0)
+            conn_->set_session_var("statement_timeout", std::to_string(options_.statement_timeout.count()));
+    }
+    return *conn_;
+}
+
+EventSinkStats CEventSink::GetStats() const
+{
+    EventSinkStats stats;
+    stats.emitted = emitted_;
+    stats.written = written_;
+    stats.discarded = discarded_;
+    stats.overrun = overrun_;
+    stats.dropped = dropped_;
+    stats.flushes = flushes_;
+    stats.failures = failures_;
+    stats.queued = queue_.Size();
+    return stats;
+}
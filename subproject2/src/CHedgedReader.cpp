@@ -0,0 +1,312 @@
+#include "CHedgedReader.h"
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <utility>
+#include "spdlog/spdlog.h"
+
+#include "CQueryMetrics.h"
+#include "CQueryWatchdog.h"
+
+extern std::shared_ptr<spdlog::logger> g_logger;
+
+// 一次 Run 的共享状态：最多两路，下标 0 为首发，1 为对冲
+struct CHedgedReader::Request
+{
+    QueryFunc fn;
+    Policy *policy = nullptr;
+    std::chrono::steady_clock::time_point start; // 首发一路的发出时间
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    int launched = 0;
+    int failed = 0;
+    bool done = false;             // 已有一路成功返回
+    pqxx::result result;
+    std::exception_ptr error;      // 第一个失败的异常
+    int targets[2] = {-1, -1};     // 各路借出连接的目标（见 CRoutedPool::AcquireRead）
+    pqxx::connection *conns[2] = {nullptr, nullptr}; // 正在执行查询的连接，用于取消
+    bool cancel_sent[2] = {false, false};
+    bool cancelling[2] = {false, false}; // 正在锁外发送取消请求，该路须等它结束后才能归还连接
+};
+
+CHedgedReader::CHedgedReader(CRoutedPool &pool, HedgeOptions options)
+    : pool_(pool), options_(std::move(options))
+{
+    if (options_.window == 0)
+        options_.window = 1;
+    if (options_.workers == 0)
+        options_.workers = 1;
+
+    workers_.reserve(options_.workers);
+    for (size_t i = 0; i < options_.workers; ++i)
+        workers_.emplace_back(&CHedgedReader::WorkerLoop, this);
+}
+
+CHedgedReader::~CHedgedReader()
+{
+    // 落后的一路引用了连接池和本对象，工作线程执行完队列中剩余的各路后才退出
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        stopping_ = true;
+    }
+    tasks_cv_.notify_all();
+    for (auto &worker : workers_)
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+}
+
+void CHedgedReader::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(tasks_mutex_);
+            tasks_cv_.wait(lock, [this]
+                           { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty())
+                return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+CHedgedReader::Policy &CHedgedReader::GetPolicy(const std::string &name)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(policies_mutex_);
+        auto found = policies_.find(name);
+        if (found != policies_.end())
+            return *found->second;
+    }
+
+    // 首次出现的语句名：样本不足之前使用对冲延迟上限
+    std::unique_lock<std::shared_mutex> lock(policies_mutex_);
+    auto &policy = policies_[name];
+    if (!policy)
+    {
+        policy = std::make_unique<Policy>();
+        policy->delay_us = std::chrono::duration_cast<std::chrono::microseconds>(options_.max_delay).count();
+    }
+    return *policy;
+}
+
+void CHedgedReader::RecordLatency(Policy &policy, std::chrono::steady_clock::duration elapsed)
+{
+    policy.latency.Record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+    if (policy.samples.fetch_add(1, std::memory_order_relaxed) + 1 < options_.window)
+        return;
+
+    // 每满一个窗口重新计算分位数并清零，延迟分布变化后对冲延迟随之调整
+    std::unique_lock<std::mutex> lock(policy.refresh_mutex, std::try_to_lock);
+    if (!lock.owns_lock())
+        return;
+    policy.samples = 0;
+    CLatencyHistogram::Snapshot snapshot = policy.latency.Take(true);
+    if (snapshot.count == 0)
+        return;
+
+    const int64_t lower = std::chrono::duration_cast<std::chrono::microseconds>(options_.min_delay).count();
+    const int64_t upper = std::chrono::duration_cast<std::chrono::microseconds>(options_.max_delay).count();
+    const int64_t delay = static_cast<int64_t>(snapshot.Percentile(options_.percentile));
+    policy.delay_us = std::clamp(delay, lower, std::max(lower, upper));
+}
+
+void CHedgedReader::Launch(const std::shared_ptr<Request> &request, int attempt, int avoid)
+{
+    // 调用者持有 request->mutex
+    ++request->launched;
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        tasks_.emplace_back([this, request, attempt, avoid]
+                            { Attempt(request, attempt, avoid); });
+    }
+    tasks_cv_.notify_one();
+}
+
+void CHedgedReader::Attempt(const std::shared_ptr<Request> &request, int attempt, int avoid)
+{
+    {
+        // 排队期间另一路已返回，不再借出连接
+        std::lock_guard<std::mutex> lock(request->mutex);
+        if (request->done)
+            return;
+    }
+
+    CConnectionPool::Handle handle;
+    try
+    {
+        int target = 0;
+        handle = pool_.AcquireRead(avoid, target);
+        {
+            std::lock_guard<std::mutex> lock(request->mutex);
+            request->targets[attempt] = target;
+            if (request->done)
+                return; // 借出连接期间另一路已返回，不再执行
+            request->conns[attempt] = &handle.Conn();
+        }
+
+        pqxx::result result;
+        {
+            CQueryWatchdog::Scope deadline(handle, options_.timeout);
+            result = request->fn(handle);
+        }
+
+        // 胜出时在锁内只标记要取消的一路，先唤醒调用者，再在锁外发送取消请求
+        // （cancel_query 要新建连接，可能耗时较长）
+        pqxx::connection *loser = nullptr;
+        int loser_attempt = -1;
+        {
+            std::unique_lock<std::mutex> lock(request->mutex);
+            request->conns[attempt] = nullptr;
+            // 另一路可能正在锁外向本连接发送取消请求，须等它结束后才能归还连接
+            request->cv.wait(lock, [&]
+                             { return !request->cancelling[attempt]; });
+            // 取消请求经独立连接发送，可能在查询结束后才到达服务端，
+            // 连接若放回连接池会误伤下一次查询，直接关闭
+            if (request->cancel_sent[attempt])
+                handle.Invalidate();
+
+            if (request->done)
+                return;
+
+            request->done = true;
+            request->result = std::move(result);
+            const int other = 1 - attempt;
+            if (request->conns[other] && !request->cancel_sent[other])
+            {
+                request->cancel_sent[other] = true;
+                request->cancelling[other] = true;
+                loser = request->conns[other];
+                loser_attempt = other;
+            }
+            request->cv.notify_all();
+        }
+
+        // 首发一路的耗时从发出时算起（含排队和借出连接）；对冲一路胜出时首发一路尚未返回，
+        // 此刻已经过的时间是它耗时的下界，作为截尾样本记录
+        RecordLatency(*request->policy, std::chrono::steady_clock::now() - request->start);
+        if (attempt == 1)
+            ++hedge_wins_;
+
+        if (loser)
+        {
+            try
+            {
+                loser->cancel_query();
+                ++cancelled_;
+            }
+            catch (const std::exception &e)
+            {
+                g_logger->warn("取消落后的对冲查询失败: {}", e.what());
+            }
+            std::lock_guard<std::mutex> lock(request->mutex);
+            request->cancelling[loser_attempt] = false;
+            request->cv.notify_all();
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::unique_lock<std::mutex> lock(request->mutex);
+        request->conns[attempt] = nullptr;
+        request->cv.wait(lock, [&]
+                         { return !request->cancelling[attempt]; });
+        if (request->cancel_sent[attempt])
+        {
+            // 被胜出的一路取消：query_canceled 说明取消请求已被消费，其他错误时保守地关闭连接
+            if (!dynamic_cast<const pqxx::query_canceled *>(&e))
+                handle.Invalidate();
+            return;
+        }
+
+        g_logger->warn("对冲查询第 {} 路失败 (目标: {}): {}", attempt + 1, request->targets[attempt], e.what());
+        ++request->failed;
+        if (!request->error)
+            request->error = std::current_exception();
+        request->cv.notify_all();
+    }
+}
+
+pqxx::result CHedgedReader::Run(const std::string &name, QueryFunc fn)
+{
+    // 按调用者看到的耗时（含对冲）记为 <name>:hedged，与 fn 中各路自身的语句指标分开
+    return CQueryMetrics::GetInstance().Measure(name + ":hedged", [&]
+                                                { return Execute(name, std::move(fn)); });
+}
+
+pqxx::result CHedgedReader::Execute(const std::string &name, QueryFunc fn)
+{
+    ++requests_;
+    if (!options_.enabled)
+    {
+        int target = 0;
+        CConnectionPool::Handle handle = pool_.AcquireRead(-1, target);
+        CQueryWatchdog::Scope deadline(handle, options_.timeout);
+        return fn(handle);
+    }
+
+    Policy &policy = GetPolicy(name);
+    auto request = std::make_shared<Request>();
+    request->fn = std::move(fn);
+    request->policy = &policy;
+
+    auto finished = [&request]
+    { return request->done || request->failed == request->launched; };
+
+    std::unique_lock<std::mutex> lock(request->mutex);
+    request->start = std::chrono::steady_clock::now();
+    Launch(request, 0, -1);
+
+    // 超过对冲延迟仍未返回（且未失败）时，避开首发目标再发一路
+    if (!request->cv.wait_for(lock, std::chrono::microseconds(policy.delay_us.load()), finished))
+    {
+        ++hedged_;
+        Launch(request, 1, request->targets[0]);
+    }
+    request->cv.wait(lock, finished);
+
+    if (request->done)
+        return std::move(request->result);
+
+    ++failed_;
+    std::rethrow_exception(request->error);
+}
+
+std::chrono::microseconds CHedgedReader::CurrentDelay(const std::string &name)
+{
+    return std::chrono::microseconds(GetPolicy(name).delay_us.load());
+}
+
+HedgeStats CHedgedReader::GetStats() const
+{
+    HedgeStats stats;
+    stats.requests = requests_;
+    stats.hedged = hedged_;
+    stats.hedge_wins = hedge_wins_;
+    stats.cancelled = cancelled_;
+    stats.failed = failed_;
+    return stats;
+}
+
+void CHedgedReader::LogStats() const
+{
+    HedgeStats stats = GetStats();
+    g_logger->info("对冲读统计 - 请求数: {}, 对冲次数: {} ({:.2f}%), 对冲胜出: {}, 取消落后查询: {}, 失败: {}",
+                   stats.requests, stats.hedged,
+                   stats.requests ? 100.0 * double(stats.hedged) / double(stats.requests) : 0.0,
+                   stats.hedge_wins, stats.cancelled, stats.failed);
+
+    std::shared_lock<std::shared_mutex> lock(policies_mutex_);
+    for (const auto &item : policies_)
+    {
+        g_logger->info("对冲读统计 [{}] - 当前对冲延迟: {:.3f} ms", item.first,
+                       item.second->delay_us.load() / 1000.0);
+    }
+}
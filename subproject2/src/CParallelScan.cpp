@@ -0,0 +1,233 @@
+#include "CParallelScan.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+#include "CBoundedQueue.h"
+#include "CCursorScan.h"
+#include "CQueryMetrics.h"
+
+namespace
+{
+// 共享快照要求 REPEATABLE READ
+using SnapshotTransaction =
+    pqxx::transaction<pqxx::isolation_level::repeatable_read, pqxx::write_policy::read_only>;
+} // namespace
+
+CParallelScan::CParallelScan(CConnectionPool &pool, ParallelScanOptions options)
+    : pool_(pool), options_(std::move(options))
+{
+    if (options_.partitions < 1)
+        options_.partitions = 1;
+}
+
+std::vector<CParallelScan::Range> CParallelScan::PlanRanges(pqxx::transaction_base &txn, int partitions) const
+{
+    int64_t lower = 0;
+    int64_t upper = 0; // 不含
+    if (options_.partitioning == ScanPartitioning::KEY)
+    {
+        pqxx::row bounds = txn.exec("SELECT min(" + options_.key_column + "), max(" + options_.key_column +
+                                    ") FROM " + options_.table)
+                               .one_row();
+        if (bounds[0].is_null())
+            return {Range{}}; // 空表：单个不设边界的分区
+        lower = bounds[0].as<int64_t>();
+        upper = bounds[1].as<int64_t>() + 1;
+    }
+    else
+    {
+        upper = txn.query_value<int64_t>("SELECT pg_relation_size(" + txn.quote(options_.table) +
+                                         "::regclass) / current_setting('block_size')::int");
+        if (upper == 0)
+            return {Range{}};
+    }
+
+    // 均分 [lower, upper)；首段不设下界、末段不设上界，扫描期间新增的行也不会遗漏
+    uint64_t span = static_cast<uint64_t>(upper) - static_cast<uint64_t>(lower);
+    uint64_t count = std::min<uint64_t>(static_cast<uint64_t>(partitions), span);
+    uint64_t step = (span + count - 1) / count;
+
+    std::vector<Range> ranges;
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        Range range;
+        range.has_lower = i > 0;
+        range.has_upper = i + 1 < count;
+        range.lower = lower + static_cast<int64_t>(i * step);
+        range.upper = lower + static_cast<int64_t>((i + 1) * step);
+        ranges.push_back(range);
+    }
+    return ranges;
+}
+
+std::string CParallelScan::RangeQuery(const Range &range) const
+{
+    std::string sql = "SELECT " + options_.columns + " FROM " + options_.table;
+    auto bound = [this](int64_t value)
+    {
+        if (options_.partitioning == ScanPartitioning::KEY)
+            return std::to_string(value);
+        return "'(" + std::to_string(value) + ",0)'::tid";
+    };
+    const std::string column = options_.partitioning == ScanPartitioning::KEY ? options_.key_column : "ctid";
+
+    if (range.has_lower)
+        sql += " WHERE " + column + " >= " + bound(range.lower);
+    if (range.has_upper)
+        sql += std::string(range.has_lower ? " AND " : " WHERE ") + column + " < " + bound(range.upper);
+    return sql;
+}
+
+ParallelScanStats CParallelScan::Run(const ChunkFunc &fn)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const bool consistent = options_.consistent_snapshot;
+
+    // 分区线程同时各占一个连接，分区数不超过连接池上限，避免分区线程互相等待；
+    // 共享快照时协调连接一直占用，再减一
+    const int max_size = pool_.GetOptions().max_size;
+    const int partitions = std::max(1, std::min(options_.partitions, consistent ? max_size - 1 : max_size));
+    // 共享快照但连接池只有一个连接时，分区线程再借连接会永远等待协调连接归还：
+    // 改为在协调事务上单分区扫描（REPEATABLE READ，结果同样一致）
+    const bool on_coordinator = consistent && max_size < 2;
+
+    // 1、协调连接：规划分区；共享快照时导出快照并保持事务打开，直到所有分区结束
+    CConnectionPool::Handle coordinator = pool_.Acquire();
+    std::unique_ptr<pqxx::transaction_base> plan_txn;
+    std::string snapshot;
+    if (consistent)
+    {
+        plan_txn = std::make_unique<SnapshotTransaction>(coordinator.Conn());
+        if (!on_coordinator)
+            snapshot = plan_txn->query_value<std::string>("SELECT pg_export_snapshot()");
+    }
+    else
+    {
+        plan_txn = std::make_unique<pqxx::read_transaction>(coordinator.Conn());
+    }
+    const std::vector<Range> ranges = PlanRanges(*plan_txn, partitions);
+    if (!consistent)
+    {
+        plan_txn->commit();
+        plan_txn.reset();
+        coordinator.Reset();
+    }
+
+    // 2、每个分区一个线程，读到的块放入有界队列
+    CBoundedQueue<ScanChunk> queue(options_.queue_capacity);
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> active{ranges.size()};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto fail = [&](std::exception_ptr e)
+    {
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error)
+                error = e;
+        }
+        stop = true;
+        queue.Close();
+    };
+
+    // 每个分区的扫描按 parallel_scan:<表名> 记入 CQueryMetrics
+    auto &metrics = CQueryMetrics::GetInstance();
+    const std::string metrics_name = "parallel_scan:" + options_.table;
+
+    std::vector<std::thread> workers;
+    workers.reserve(ranges.size());
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        workers.emplace_back([&, i]
+        {
+            const auto partition_start = std::chrono::steady_clock::now();
+            try
+            {
+                size_t bytes = 0;
+                auto scan = [&](pqxx::transaction_base &txn)
+                {
+                    return CursorScan(txn, RangeQuery(ranges[i]), options_.fetch_size,
+                                      [&](const pqxx::result &chunk)
+                                      {
+                                          if (metrics.Enabled())
+                                              bytes += CQueryMetrics::ResultBytes(chunk);
+                                          if (stop || !queue.Push(ScanChunk{static_cast<int>(i), chunk}))
+                                              throw std::runtime_error("并行扫描已取消");
+                                      },
+                                      false, "parallel_scan_" + std::to_string(i));
+                };
+
+                size_t rows = 0;
+                if (on_coordinator)
+                {
+                    // 调用线程只在 join 之后才再使用协调事务，由它负责提交
+                    rows = scan(*plan_txn);
+                }
+                else
+                {
+                    CConnectionPool::Handle handle = pool_.Acquire();
+                    std::unique_ptr<pqxx::transaction_base> txn;
+                    if (consistent)
+                    {
+                        txn = std::make_unique<SnapshotTransaction>(handle.Conn());
+                        txn->exec("SET TRANSACTION SNAPSHOT " + txn->quote(snapshot));
+                    }
+                    else
+                    {
+                        txn = std::make_unique<pqxx::read_transaction>(handle.Conn());
+                    }
+                    rows = scan(*txn);
+                    txn->commit();
+                }
+                metrics.Record(metrics_name, std::chrono::steady_clock::now() - partition_start, rows, bytes);
+            }
+            catch (...)
+            {
+                if (!stop)
+                {
+                    metrics.RecordError(metrics_name, std::chrono::steady_clock::now() - partition_start);
+                    fail(std::current_exception());
+                }
+            }
+            if (--active == 0)
+                queue.Close(); // 最后一个分区结束，消费者取完剩余块后退出
+        });
+    }
+
+    // 3、调用线程依次处理各块
+    ParallelScanStats stats;
+    stats.partition_rows.assign(ranges.size(), 0);
+    try
+    {
+        while (std::optional<ScanChunk> chunk = queue.Pop())
+        {
+            stats.rows += chunk->rows.size();
+            stats.partition_rows[chunk->partition] += chunk->rows.size();
+            ++stats.chunks;
+            fn(*chunk);
+        }
+    }
+    catch (...)
+    {
+        fail(std::current_exception());
+    }
+
+    for (auto &worker : workers)
+        worker.join();
+    // 出错时协调事务可能已中止（在其上扫描的分区失败），由析构回滚，避免提交失败掩盖原始异常
+    if (plan_txn && !error)
+        plan_txn->commit();
+
+    if (error)
+        std::rethrow_exception(error);
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
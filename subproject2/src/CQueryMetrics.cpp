@@ -0,0 +1,164 @@
+#include "CQueryMetrics.h"
+
+#include <algorithm>
+#include <utility>
+#include "spdlog/spdlog.h"
+
+extern std::shared_ptr<spdlog::logger> g_logger;
+
+CQueryMetrics::~CQueryMetrics()
+{
+    Stop();
+}
+
+StatementMetrics &CQueryMetrics::Get(const std::string &name)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto found = statements_.find(name);
+        if (found != statements_.end())
+            return *found->second;
+    }
+
+    // 首次出现的语句名：升级为写锁创建
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto &metrics = statements_[name];
+    if (!metrics)
+        metrics = std::make_unique<StatementMetrics>();
+    return *metrics;
+}
+
+void CQueryMetrics::Record(const std::string &name, std::chrono::steady_clock::duration elapsed,
+                           size_t rows, size_t bytes)
+{
+    Record(Get(name), elapsed, rows, bytes);
+}
+
+void CQueryMetrics::RecordError(const std::string &name, std::chrono::steady_clock::duration elapsed)
+{
+    RecordError(Get(name), elapsed);
+}
+
+void CQueryMetrics::Record(StatementMetrics &metrics, std::chrono::steady_clock::duration elapsed,
+                           size_t rows, size_t bytes)
+{
+    metrics.latency.Record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+    metrics.rows.fetch_add(rows, std::memory_order_relaxed);
+    metrics.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void CQueryMetrics::RecordError(StatementMetrics &metrics, std::chrono::steady_clock::duration elapsed)
+{
+    metrics.latency.Record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+    metrics.errors.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t CQueryMetrics::ResultBytes(const pqxx::result &result)
+{
+    size_t bytes = 0;
+    for (const auto &row : result)
+    {
+        for (const auto &field : row)
+            bytes += field.size();
+    }
+    return bytes;
+}
+
+void CQueryMetrics::Start(std::chrono::seconds interval)
+{
+    std::lock_guard<std::mutex> lock(report_mutex_);
+    if (running_ || interval.count() <= 0)
+        return;
+    running_ = true;
+    interval_ = interval;
+    window_start_ = std::chrono::steady_clock::now();
+    reporter_ = std::thread(&CQueryMetrics::ReportLoop, this);
+}
+
+void CQueryMetrics::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(report_mutex_);
+        if (!running_)
+            return;
+        running_ = false;
+    }
+    report_cv_.notify_one();
+    if (reporter_.joinable())
+        reporter_.join();
+}
+
+void CQueryMetrics::ReportLoop()
+{
+    std::unique_lock<std::mutex> lock(report_mutex_);
+    while (running_)
+    {
+        if (report_cv_.wait_for(lock, interval_, [this]
+                                { return !running_; }))
+            break;
+        lock.unlock();
+        Report();
+        lock.lock();
+    }
+}
+
+void CQueryMetrics::Report()
+{
+    double seconds;
+    {
+        std::lock_guard<std::mutex> lock(report_mutex_);
+        auto now = std::chrono::steady_clock::now();
+        seconds = std::chrono::duration<double>(now - window_start_).count();
+        window_start_ = now;
+    }
+    if (seconds <= 0.0)
+        seconds = 1e-9;
+
+    // 复制语句列表后在锁外取快照，不阻塞新语句的登记
+    std::vector<std::pair<std::string, StatementMetrics *>> statements;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        statements.reserve(statements_.size());
+        for (auto &entry : statements_)
+            statements.emplace_back(entry.first, entry.second.get());
+    }
+    std::sort(statements.begin(), statements.end());
+
+    for (auto &[name, metrics] : statements)
+    {
+        CLatencyHistogram::Snapshot latency = metrics->latency.Take(true);
+        uint64_t rows = metrics->rows.exchange(0, std::memory_order_relaxed);
+        uint64_t bytes = metrics->bytes.exchange(0, std::memory_order_relaxed);
+        uint64_t errors = metrics->errors.exchange(0, std::memory_order_relaxed);
+        if (latency.count == 0)
+            continue;
+
+        g_logger->info("SQL 统计 [{}] - 调用: {}, 错误: {}, QPS: {:.1f}, p50: {:.3f} ms, p90: {:.3f} ms, "
+                       "p99: {:.3f} ms, p999: {:.3f} ms, 最大: {:.3f} ms, 行/秒: {:.1f}, KB/秒: {:.1f}",
+                       name, latency.count, errors, double(latency.count) / seconds,
+                       latency.Percentile(0.50) / 1000.0, latency.Percentile(0.90) / 1000.0,
+                       latency.Percentile(0.99) / 1000.0, latency.Percentile(0.999) / 1000.0,
+                       latency.max / 1000.0, double(rows) / seconds, double(bytes) / 1024.0 / seconds);
+    }
+
+    // 注销与报告互斥，读取期间 gauge 引用的对象不会被销毁
+    std::lock_guard<std::mutex> lock(gauges_mutex_);
+    for (const auto &[name, read] : gauges_)
+    {
+        g_logger->info("指标 [{}] - 当前值: {}", name, read());
+    }
+}
+
+void CQueryMetrics::SetGauge(const std::string &name, std::function<double()> read)
+{
+    std::lock_guard<std::mutex> lock(gauges_mutex_);
+    gauges_[name] = std::move(read);
+}
+
+void CQueryMetrics::RemoveGauge(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(gauges_mutex_);
+    gauges_.erase(name);
+}
@@ -0,0 +1,254 @@
+#include "CQueryWatchdog.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "spdlog/spdlog.h"
+
+extern std::shared_ptr<spdlog::logger> g_logger;
+
+CQueryWatchdog::Scope::Scope(CConnectionPool::Handle &handle, std::chrono::milliseconds timeout)
+    : entry_(handle.GetEntry())
+{
+    if (!CQueryWatchdog::GetInstance().BeginScope(entry_, timeout))
+        throw std::runtime_error("程序正在退出，不再执行新的查询");
+
+    // 服务端超时：连接条目记录当前会话的取值，相同则不再 SET，稳定状态下没有额外往返
+    const int64_t timeout_ms = timeout.count() > 0 ? static_cast<int64_t>(timeout.count()) : 0;
+    if (entry_.statement_timeout_ms != timeout_ms)
+    {
+        try
+        {
+            entry_.conn->set_session_var("statement_timeout", std::to_string(timeout_ms));
+        }
+        catch (...)
+        {
+            CQueryWatchdog::GetInstance().EndScope(entry_);
+            throw;
+        }
+        entry_.statement_timeout_ms = timeout_ms;
+    }
+}
+
+CQueryWatchdog::Scope::~Scope()
+{
+    CQueryWatchdog::GetInstance().EndScope(entry_);
+}
+
+bool CQueryWatchdog::Scope::Cancelled() const
+{
+    return CQueryWatchdog::GetInstance().Cancelled(entry_);
+}
+
+CQueryWatchdog::~CQueryWatchdog()
+{
+    Stop();
+}
+
+void CQueryWatchdog::Start(const std::atomic<bool> *shutdown_flag, std::chrono::milliseconds shutdown_check)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_)
+        return;
+    shutdown_flag_ = shutdown_flag;
+    shutdown_check_ = shutdown_check;
+    running_ = true;
+    thread_ = std::thread(&CQueryWatchdog::Run, this);
+}
+
+void CQueryWatchdog::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+            return;
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void CQueryWatchdog::Register(CConnectionPool::Entry &entry)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++registered_;
+    if (ShuttingDown())
+    {
+        // 正在退出：查询尚未发出，取消请求会被服务端忽略，直接拒绝借出
+        ++shutdown_cancels_;
+        throw std::runtime_error("程序正在退出，不再借出连接");
+    }
+    Checkout &checkout = checkouts_[&entry];
+    checkout = Checkout{};
+    checkout.conn = entry.conn.get();
+    cv_.notify_all(); // 看门狗可能需要开始检查关闭标志
+}
+
+bool CQueryWatchdog::Unregister(CConnectionPool::Entry &entry)
+{
+    // 等待针对该连接、正在锁外发送的取消请求结束：返回后不会再有针对该连接的取消请求
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = checkouts_.find(&entry);
+    if (it == checkouts_.end())
+        return false;
+    Checkout &checkout = it->second; // 元素引用在其他登记引起重新散列后仍然有效
+    cancel_cv_.wait(lock, [&checkout]
+                    { return !checkout.cancelling; });
+    const bool cancelled = checkout.cancelled;
+    checkouts_.erase(&entry);
+    return cancelled;
+}
+
+bool CQueryWatchdog::BeginScope(CConnectionPool::Entry &entry, std::chrono::milliseconds timeout)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++scopes_;
+    if (ShuttingDown())
+        return false;
+
+    // 未经 Acquire 登记的连接（如预热中的连接）只设置服务端超时
+    auto it = checkouts_.find(&entry);
+    if (it == checkouts_.end() || timeout.count() <= 0)
+        return true;
+    it->second.has_deadline = true;
+    it->second.deadline = std::chrono::steady_clock::now() + timeout;
+    cv_.notify_all(); // 看门狗可能需要提前醒来（新的最早截止时间）
+    return true;
+}
+
+void CQueryWatchdog::EndScope(CConnectionPool::Entry &entry)
+{
+    // 恢复为不设截止时间，连接仍登记到归还为止
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = checkouts_.find(&entry);
+    if (it != checkouts_.end())
+        it->second.has_deadline = false;
+}
+
+bool CQueryWatchdog::Cancelled(CConnectionPool::Entry &entry) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = checkouts_.find(&entry);
+    return it != checkouts_.end() && it->second.cancelled;
+}
+
+bool CQueryWatchdog::MarkCancelled(Checkout &checkout, std::vector<Checkout *> &targets)
+{
+    if (checkout.cancelled)
+        return false;
+    checkout.cancelled = true;
+    checkout.cancelling = true;
+    targets.push_back(&checkout);
+    return true;
+}
+
+void CQueryWatchdog::SendCancels(std::unique_lock<std::mutex> &lock, std::vector<Checkout *> &targets)
+{
+    if (targets.empty())
+        return;
+
+    // cancelling 置位期间 Unregister 不会移除这些条目，锁外访问 conn 是安全的
+    lock.unlock();
+    for (Checkout *checkout : targets)
+    {
+        try
+        {
+            checkout->conn->cancel_query();
+        }
+        catch (const std::exception &e)
+        {
+            g_logger->warn("取消查询失败: {}", e.what());
+        }
+    }
+    lock.lock();
+
+    for (Checkout *checkout : targets)
+        checkout->cancelling = false;
+    targets.clear();
+    cancel_cv_.notify_all();
+}
+
+void CQueryWatchdog::CancelAll()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::vector<Checkout *> targets;
+    for (auto &item : checkouts_)
+    {
+        if (MarkCancelled(item.second, targets))
+            ++shutdown_cancels_;
+    }
+    SendCancels(lock, targets);
+}
+
+void CQueryWatchdog::Run()
+{
+    std::vector<Checkout *> targets;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_)
+    {
+        size_t shutdown_cancelled = 0;
+        if (ShuttingDown())
+        {
+            for (auto &item : checkouts_)
+            {
+                if (MarkCancelled(item.second, targets))
+                    ++shutdown_cancelled;
+            }
+            shutdown_cancels_ += shutdown_cancelled;
+        }
+
+        // 取消已超过截止时间的请求，并找出下一个截止时间
+        const auto now = std::chrono::steady_clock::now();
+        auto wake = std::chrono::steady_clock::time_point::max();
+        for (auto &item : checkouts_)
+        {
+            Checkout &checkout = item.second;
+            if (!checkout.has_deadline || checkout.cancelled)
+                continue;
+            if (checkout.deadline <= now)
+            {
+                ++deadline_cancels_;
+                MarkCancelled(checkout, targets);
+            }
+            else if (checkout.deadline < wake)
+            {
+                wake = checkout.deadline;
+            }
+        }
+
+        // 发送期间的新登记不会唤醒本线程，发送完后重新扫描一遍再计算等待时间
+        if (!targets.empty())
+        {
+            SendCancels(lock, targets);
+            if (shutdown_cancelled > 0)
+            {
+                lock.unlock();
+                g_logger->warn("正在退出，已取消 {} 个已借出连接上的查询", shutdown_cancelled);
+                lock.lock();
+            }
+            continue;
+        }
+
+        // 有已借出连接时定期检查关闭标志；没有时一直等到有新登记
+        if (shutdown_flag_.load() && !checkouts_.empty())
+            wake = std::min(wake, now + shutdown_check_);
+
+        if (wake == std::chrono::steady_clock::time_point::max())
+            cv_.wait(lock);
+        else
+            cv_.wait_until(lock, wake);
+    }
+}
+
+WatchdogStats CQueryWatchdog::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    WatchdogStats stats;
+    stats.checkouts = registered_;
+    stats.scopes = scopes_;
+    stats.deadline_cancels = deadline_cancels_;
+    stats.shutdown_cancels = shutdown_cancels_;
+    stats.in_flight = checkouts_.size();
+    return stats;
+}
@@ -0,0 +1,170 @@
+#include "CRoutedPool.h"
+
+#include <algorithm>
+#include <future>
+#include "spdlog/spdlog.h"
+
+#include "CQueryWatchdog.h"
+
+extern std::shared_ptr<spdlog::logger> g_logger;
+
+namespace
+{
+int64_t NowNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+} // namespace
+
+CRoutedPool::CRoutedPool(PoolOptions primary, std::vector<PoolOptions> replicas,
+                         std::chrono::milliseconds retry_after)
+    : retry_after_(retry_after)
+{
+    // 副本连接池与主库连接池同时建立
+    std::vector<std::future<std::unique_ptr<CConnectionPool>>> pending;
+    pending.reserve(replicas.size());
+    for (auto &options : replicas)
+    {
+        pending.push_back(std::async(std::launch::async, [&options]
+                                     { return std::make_unique<CConnectionPool>(options); }));
+    }
+    primary_ = std::make_unique<CConnectionPool>(std::move(primary));
+
+    replicas_.reserve(replicas.size());
+    for (size_t i = 0; i < replicas.size(); ++i)
+    {
+        auto slot = std::make_unique<ReplicaSlot>();
+        slot->name = "replica-" + std::to_string(i + 1);
+        try
+        {
+            slot->pool = pending[i].get();
+        }
+        catch (const std::exception &e)
+        {
+            // 副本不可用不影响启动：先建立空池并暂停使用，之后按需重连
+            g_logger->warn("只读副本 {} 初始化失败: {}，暂停使用 {} ms", slot->name, e.what(), retry_after_.count());
+            replicas[i].min_size = 0;
+            slot->pool = std::make_unique<CConnectionPool>(replicas[i]);
+            slot->down_until = NowNanos() + std::chrono::nanoseconds(retry_after_).count();
+        }
+        replicas_.push_back(std::move(slot));
+    }
+}
+
+std::vector<size_t> CRoutedPool::RankReplicas() const
+{
+    int64_t now = NowNanos();
+    std::vector<std::pair<int, size_t>> ranked;
+    ranked.reserve(replicas_.size());
+    for (size_t i = 0; i < replicas_.size(); ++i)
+    {
+        if (replicas_[i]->down_until.load(std::memory_order_relaxed) > now)
+            continue;
+        ranked.emplace_back(replicas_[i]->pool->Outstanding(), i);
+    }
+    std::sort(ranked.begin(), ranked.end());
+
+    std::vector<size_t> order;
+    order.reserve(ranked.size());
+    for (const auto &item : ranked)
+        order.push_back(item.second);
+    return order;
+}
+
+CConnectionPool::Handle CRoutedPool::Acquire(Route route)
+{
+    if (route == Route::REPLICA)
+    {
+        int target = 0;
+        return AcquireRead(-1, target);
+    }
+
+    ++primary_routed_;
+    return primary_->Acquire();
+}
+
+CConnectionPool::Handle CRoutedPool::AcquireRead(int avoid, int &target)
+{
+    // 依次尝试未完成请求最少的副本，失败的副本暂停使用
+    for (size_t index : RankReplicas())
+    {
+        if (static_cast<int>(index) + 1 == avoid)
+            continue;
+        ReplicaSlot &slot = *replicas_[index];
+        try
+        {
+            CConnectionPool::Handle handle = slot.pool->Acquire();
+            ++slot.routed;
+            target = static_cast<int>(index) + 1;
+            return handle;
+        }
+        catch (const std::exception &e)
+        {
+            // 程序正在退出时借出被拒绝，与副本是否可用无关
+            if (CQueryWatchdog::GetInstance().ShuttingDown())
+                throw;
+            slot.down_until = NowNanos() + std::chrono::nanoseconds(retry_after_).count();
+            g_logger->warn("只读副本 {} 借出连接失败: {}，暂停使用 {} ms", slot.name, e.what(),
+                           retry_after_.count());
+        }
+    }
+
+    ++primary_routed_;
+    target = 0;
+    return primary_->Acquire();
+}
+
+std::vector<uint64_t> CRoutedPool::GetRouteCounts() const
+{
+    std::vector<uint64_t> counts;
+    counts.reserve(replicas_.size() + 1);
+    counts.push_back(primary_routed_);
+    for (const auto &slot : replicas_)
+        counts.push_back(slot->routed);
+    return counts;
+}
+
+void CRoutedPool::LogStats() const
+{
+    auto log_pool = [](const std::string &name, uint64_t routed, const CConnectionPool &pool)
+    {
+        PoolStats stats = pool.GetStats();
+        g_logger->info("连接池统计 [{}] - 路由次数: {}, 总连接: {}, 使用中: {}, 空闲: {}, 等待中: {}, 借出次数: {}, "
+                       "超时次数: {}, 平均等待: {:.3f} ms, 最长等待: {:.3f} ms",
+                       name, routed, stats.total, stats.in_use, stats.idle, stats.waiting, stats.checkouts,
+                       stats.timeouts, stats.avg_wait_ms, stats.max_wait_ms);
+    };
+
+    log_pool("primary", primary_routed_, *primary_);
+    for (const auto &slot : replicas_)
+        log_pool(slot->name, slot->routed, *slot->pool);
+}
+
+int CRoutedPool::Warmup(const std::function<void(PooledConnection &)> &fn)
+{
+    // 各连接池同时预热
+    std::vector<std::future<int>> replica_results;
+    replica_results.reserve(replicas_.size());
+    for (auto &slot : replicas_)
+    {
+        replica_results.push_back(std::async(std::launch::async, [&slot, &fn]
+                                             { return slot->pool->Warmup(fn); }));
+    }
+    int healthy = primary_->Warmup(fn);
+    g_logger->info("连接预热 [primary] - 通过: {}", healthy);
+
+    for (size_t i = 0; i < replicas_.size(); ++i)
+    {
+        ReplicaSlot &slot = *replicas_[i];
+        int replica_healthy = replica_results[i].get();
+        g_logger->info("连接预热 [{}] - 通过: {}", slot.name, replica_healthy);
+        if (replica_healthy == 0 && slot.pool->GetOptions().min_size > 0)
+        {
+            slot.down_until = NowNanos() + std::chrono::nanoseconds(retry_after_).count();
+            g_logger->warn("只读副本 {} 预热失败，暂停使用 {} ms", slot.name, retry_after_.count());
+        }
+    }
+    return healthy;
+}
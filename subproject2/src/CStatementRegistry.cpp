@@ -0,0 +1,152 @@
+#include "CStatementRegistry.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include "spdlog/spdlog.h"
+
+extern std::shared_ptr<spdlog::logger> g_logger;
+
+namespace
+{
+void MarkTyped(CConnectionPool::Entry &entry, size_t id)
+{
+    if (id >= entry.typed_prepared.size())
+        entry.typed_prepared.resize(id + 1, false);
+    entry.typed_prepared[id] = true;
+}
+} // namespace
+
+void CStatementRegistry::Register(const std::string &name, const std::string &sql, Validator validate)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    catalog_[name] = Statement{sql, validate};
+}
+
+size_t CStatementRegistry::RegisterTyped(const std::string &name, const std::string &sql, Validator validate)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Statement &statement = catalog_[name];
+    statement.sql = sql;
+    statement.validate = validate;
+    if (statement.typed_id == NOT_TYPED)
+        statement.typed_id = next_typed_id_++;
+    return statement.typed_id;
+}
+
+bool CStatementRegistry::Contains(const std::string &name) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return catalog_.count(name) > 0;
+}
+
+std::string CStatementRegistry::GetSql(const std::string &name) const
+{
+    return Get(name).sql;
+}
+
+CStatementRegistry::Statement CStatementRegistry::Get(const std::string &name) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = catalog_.find(name);
+    if (it == catalog_.end())
+    {
+        throw std::out_of_range("未登记的预处理语句: " + name);
+    }
+    return it->second;
+}
+
+void CStatementRegistry::Ensure(CConnectionPool::Entry &entry, const std::string &name)
+{
+    // 连接条目同一时刻只属于一个借出者，prepared 集合无需加锁
+    if (entry.prepared.count(name) > 0)
+        return;
+
+    Prepare(entry, name, Get(name), nullptr);
+}
+
+void CStatementRegistry::Ensure(pqxx::transaction_base &txn, CConnectionPool::Entry &entry,
+                                const std::string &name)
+{
+    if (entry.prepared.count(name) > 0)
+        return;
+
+    Prepare(entry, name, Get(name), &txn);
+}
+
+void CStatementRegistry::EnsureTyped(pqxx::transaction_base &txn, CConnectionPool::Entry &entry,
+                                     const std::string &name, size_t id)
+{
+    // 语句可能已按名称准备（如 PrepareAll），此时只需补上序号标记
+    Ensure(txn, entry, name);
+    MarkTyped(entry, id);
+}
+
+void CStatementRegistry::PrepareAll(CConnectionPool::Entry &entry)
+{
+    // 先复制目录，准备语句需要与服务端交互，不在锁内进行
+    std::vector<std::pair<std::string, Statement>> statements;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        statements.assign(catalog_.begin(), catalog_.end());
+    }
+
+    for (const auto &[name, statement] : statements)
+    {
+        if (entry.prepared.count(name) > 0)
+            continue;
+        try
+        {
+            Prepare(entry, name, statement, nullptr);
+        }
+        catch (const std::logic_error &e)
+        {
+            // 声明与语句不一致：不影响连接本身，语句保持未准备，首次使用时再次准备并把错误交给调用者
+            g_logger->error("预处理语句 {} 校验未通过: {}", name, e.what());
+        }
+    }
+}
+
+void CStatementRegistry::Prepare(CConnectionPool::Entry &entry, const std::string &name,
+                                 const Statement &statement, pqxx::transaction_base *txn)
+{
+    entry.conn->prepare(name, statement.sql);
+    if (statement.validate)
+    {
+        bool complete = true;
+        try
+        {
+            if (txn)
+            {
+                complete = statement.validate(*txn);
+            }
+            else
+            {
+                pqxx::nontransaction tx(*entry.conn);
+                complete = statement.validate(tx);
+            }
+        }
+        catch (...)
+        {
+            // 不记为已准备：撤销后下次使用时重新准备（并再次报告校验错误），而不是报语句已存在
+            try
+            {
+                entry.conn->unprepare(name);
+            }
+            catch (const std::exception &)
+            {
+            }
+            throw;
+        }
+
+        // 服务端不支持完整校验（PostgreSQL 16 之前无法校验结果列数）：只提示一次，列数在取得结果时校验
+        static std::atomic<bool> warned{false};
+        if (!complete && !warned.exchange(true))
+        {
+            g_logger->warn("服务端版本低于 PostgreSQL 16，类型化查询（首个: {}）的结果列数改为在取得结果时校验", name);
+        }
+    }
+    entry.prepared.insert(name);
+    if (statement.typed_id != NOT_TYPED)
+        MarkTyped(entry, statement.typed_id);
+}
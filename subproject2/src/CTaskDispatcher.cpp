@@ -0,0 +1,210 @@
+#include "CTaskDispatcher.h"
+
+#include "spdlog/spdlog.h"
+
+extern std::shared_ptr<spdlog::logger> g_logger;
+
+// 收到通知时把 payload 分配给工作线程（在 await_notification 所在的分发线程中调用）
+class CTaskDispatcher::Receiver : public pqxx::notification_receiver
+{
+public:
+    Receiver(pqxx::connection &conn, const std::string &channel, CTaskDispatcher &dispatcher)
+        : pqxx::notification_receiver(conn, channel), dispatcher_(dispatcher) {}
+
+    void operator()(const std::string &payload, int /*backend_pid*/) override
+    {
+        ++dispatcher_.notifications_;
+        dispatcher_.Dispatch(Task{payload, std::chrono::steady_clock::now()});
+    }
+
+private:
+    CTaskDispatcher &dispatcher_;
+};
+
+CTaskDispatcher::CTaskDispatcher(DispatcherOptions options, TaskFunc handler)
+    : options_(std::move(options)), handler_(std::move(handler))
+{
+    if (options_.workers < 1)
+        options_.workers = 1;
+    workers_.reserve(options_.workers);
+    for (int i = 0; i < options_.workers; ++i)
+    {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+}
+
+CTaskDispatcher::~CTaskDispatcher()
+{
+    Stop();
+}
+
+void CTaskDispatcher::Start()
+{
+    if (started_.exchange(true))
+        return;
+    running_ = true;
+    for (int i = 0; i < static_cast<int>(workers_.size()); ++i)
+    {
+        workers_[i]->thread = std::thread(&CTaskDispatcher::WorkerLoop, this, i);
+    }
+    listener_ = std::thread(&CTaskDispatcher::ListenLoop, this);
+}
+
+void CTaskDispatcher::Stop()
+{
+    if (!started_.exchange(false))
+        return;
+    running_ = false;
+    if (listener_.joinable())
+        listener_.join();
+    Shutdown();
+}
+
+void CTaskDispatcher::Wait()
+{
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    done_cv_.wait(lock, [this]
+                  { return listener_done_; });
+}
+
+void CTaskDispatcher::Post(std::string payload)
+{
+    Dispatch(Task{std::move(payload), std::chrono::steady_clock::now()});
+}
+
+void CTaskDispatcher::Dispatch(Task task)
+{
+    // 选择待处理任务最少的工作线程，从轮转起点开始比较，使空闲线程轮流接到任务
+    const size_t count = workers_.size();
+    const size_t start = next_worker_++ % count;
+    size_t best = start;
+    int best_pending = workers_[start]->pending.load();
+    for (size_t k = 1; k < count && best_pending > 0; ++k)
+    {
+        size_t i = (start + k) % count;
+        int pending = workers_[i]->pending.load();
+        if (pending < best_pending)
+        {
+            best = i;
+            best_pending = pending;
+        }
+    }
+
+    // 只唤醒被选中的线程
+    Worker &worker = *workers_[best];
+    ++worker.pending;
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+    worker.cv.notify_one();
+}
+
+void CTaskDispatcher::WorkerLoop(int id)
+{
+    Worker &worker = *workers_[id];
+    while (true)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            worker.cv.wait(lock, [this, &worker]
+                           { return stopping_ || !worker.tasks.empty(); });
+            if (worker.tasks.empty())
+                return; // 停止且已取完任务
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        }
+
+        pickup_us_.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                    std::chrono::steady_clock::now() - task.received)
+                                                    .count()));
+        try
+        {
+            handler_(id, task.payload);
+        }
+        catch (const std::exception &e)
+        {
+            ++failed_;
+            g_logger->error("任务执行异常 (工作线程 {}, payload: '{}'): {}", id, task.payload, e.what());
+        }
+        --worker.pending;
+        ++worker.handled;
+        ++completed_;
+    }
+}
+
+void CTaskDispatcher::Shutdown()
+{
+    stopping_ = true;
+    for (auto &worker : workers_)
+    {
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex); // 避免与等待中的工作线程错过唤醒
+        }
+        worker->cv.notify_one();
+    }
+    for (auto &worker : workers_)
+    {
+        if (worker->thread.joinable())
+            worker->thread.join();
+    }
+}
+
+void CTaskDispatcher::ListenLoop()
+{
+    const long seconds = static_cast<long>(options_.listen_timeout.count() / 1000);
+    const long microseconds = static_cast<long>(options_.listen_timeout.count() % 1000 * 1000);
+    auto should_stop = [this]
+    { return !running_ || (options_.stop_when && options_.stop_when()); };
+
+    while (!should_stop())
+    {
+        try
+        {
+            pqxx::connection conn(options_.conn_str);
+            Receiver receiver(conn, options_.channel, *this);
+            g_logger->info("任务分发器已启动 (通道: {}, 工作线程: {})", options_.channel, workers_.size());
+
+            while (!should_stop())
+            {
+                conn.await_notification(seconds, microseconds);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            // 重连期间发出的通知会丢失，依赖通知的任务应另有持久化记录以便补偿
+            ++reconnects_;
+            g_logger->error("任务分发器监听异常: {}，1 秒后重连", e.what());
+            for (int i = 0; i < 10 && !should_stop(); ++i)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        }
+    }
+
+    running_ = false;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        listener_done_ = true;
+    }
+    done_cv_.notify_all();
+}
+
+DispatcherStats CTaskDispatcher::GetStats() const
+{
+    DispatcherStats stats;
+    stats.notifications = notifications_;
+    stats.completed = completed_;
+    stats.failed = failed_;
+    stats.reconnects = reconnects_;
+    for (const auto &worker : workers_)
+    {
+        stats.per_worker.push_back(worker->handled);
+    }
+    CLatencyHistogram::Snapshot pickup = pickup_us_.Take();
+    stats.pickup_p50_ms = pickup.Percentile(0.50) / 1000.0;
+    stats.pickup_p99_ms = pickup.Percentile(0.99) / 1000.0;
+    stats.pickup_max_ms = pickup.max / 1000.0;
+    return stats;
+}
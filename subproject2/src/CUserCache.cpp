@@ -0,0 +1,255 @@
+#include "CUserCache.h"
+
+#include <charconv>
+#include "spdlog/spdlog.h"
+
+extern std::shared_ptr<spdlog::logger> g_logger;
+
+// 收到通知时把 payload 交给缓存处理（在 await_notification 所在的 LISTEN 线程中调用）
+class CUserCache::Receiver : public pqxx::notification_receiver
+{
+public:
+    Receiver(pqxx::connection &conn, const std::string &channel, CUserCache &cache)
+        : pqxx::notification_receiver(conn, channel), cache_(cache) {}
+
+    void operator()(const std::string &payload, int /*backend_pid*/) override
+    {
+        cache_.OnNotification(payload);
+    }
+
+private:
+    CUserCache &cache_;
+};
+
+CUserCache::CUserCache(CacheOptions options, LoadFunc load)
+    : options_(std::move(options)), load_(std::move(load))
+{
+    if (options_.shard_count == 0)
+        options_.shard_count = 1;
+    shard_budget_ = options_.memory_budget / options_.shard_count;
+    shards_.reserve(options_.shard_count);
+    for (size_t i = 0; i < options_.shard_count; ++i)
+    {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+CUserCache::~CUserCache()
+{
+    Stop();
+}
+
+size_t CUserCache::EstimateBytes(const UserRecord &value)
+{
+    // 节点本身 + 索引项 + 字符串堆内存的粗略估算
+    return sizeof(Node) + sizeof(void *) * 4 + value.username.capacity() + value.full_name.capacity() +
+           value.email.capacity() + value.phone.capacity();
+}
+
+void CUserCache::EraseLocked(Shard &shard, std::list<Node>::iterator it)
+{
+    shard.bytes -= it->bytes;
+    shard.index.erase(it->id);
+    shard.lru.erase(it);
+}
+
+std::optional<UserRecord> CUserCache::Get(int id)
+{
+    Shard &shard = ShardFor(id);
+    uint64_t epoch;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.index.find(id);
+        if (found != shard.index.end())
+        {
+            auto it = found->second;
+            if (std::chrono::steady_clock::now() < it->expires)
+            {
+                shard.lru.splice(shard.lru.begin(), shard.lru, it);
+                ++hits_;
+                return it->value;
+            }
+            ++expired_;
+            EraseLocked(shard, it);
+        }
+        epoch = shard.epoch;
+    }
+    ++misses_;
+
+    // 未命中：在锁外加载
+    std::optional<UserRecord> value = load_(id);
+    if (!value)
+        return value;
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.epoch != epoch)
+    {
+        // 加载期间该分片收到过失效通知，加载结果可能已过时，不写入缓存
+        ++stale_discarded_;
+        return value;
+    }
+
+    auto found = shard.index.find(id);
+    if (found != shard.index.end())
+    {
+        EraseLocked(shard, found->second); // 其他线程已并发加载，以本次结果为准
+    }
+
+    size_t bytes = EstimateBytes(*value);
+    shard.lru.push_front(Node{id, *value, bytes, std::chrono::steady_clock::now() + options_.ttl});
+    shard.index[id] = shard.lru.begin();
+    shard.bytes += bytes;
+
+    // 超出内存预算时从队尾淘汰最久未使用的项
+    while (shard.bytes > shard_budget_ && shard.lru.size() > 1)
+    {
+        EraseLocked(shard, std::prev(shard.lru.end()));
+        ++evictions_;
+    }
+    return value;
+}
+
+void CUserCache::Invalidate(int id)
+{
+    Shard &shard = ShardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    ++shard.epoch;
+    auto found = shard.index.find(id);
+    if (found != shard.index.end())
+    {
+        EraseLocked(shard, found->second);
+    }
+}
+
+void CUserCache::Clear()
+{
+    for (auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        ++shard->epoch;
+        shard->lru.clear();
+        shard->index.clear();
+        shard->bytes = 0;
+    }
+}
+
+void CUserCache::OnNotification(const std::string &payload)
+{
+    ++invalidations_;
+    int id = 0;
+    auto [ptr, ec] = std::from_chars(payload.data(), payload.data() + payload.size(), id);
+    if (ec != std::errc() || ptr != payload.data() + payload.size())
+    {
+        // 无法识别的 payload：保守起见清空全部缓存
+        g_logger->warn("缓存失效通知 payload 无法解析: '{}'，清空缓存", payload);
+        Clear();
+        return;
+    }
+    Invalidate(id);
+}
+
+void CUserCache::Start()
+{
+    if (running_.exchange(true))
+        return;
+    listener_ = std::thread(&CUserCache::ListenLoop, this);
+}
+
+void CUserCache::Stop()
+{
+    if (!running_.exchange(false))
+        return;
+    if (listener_.joinable())
+        listener_.join();
+}
+
+void CUserCache::ListenLoop()
+{
+    auto last_report = std::chrono::steady_clock::now();
+    bool reconnecting = false;
+
+    while (running_)
+    {
+        try
+        {
+            pqxx::connection conn(options_.conn_str);
+            Receiver receiver(conn, options_.channel, *this);
+            g_logger->info("缓存失效监听已启动 (通道: {})", options_.channel);
+
+            // LISTEN 生效之前（首次启动或监听中断期间）的修改收不到通知，此前缓存（或加载中）的行可能已过期。
+            // 必须在 LISTEN 生效之后再清空并推进 epoch：若在断开时清空，重连之前加载的行仍会留在缓存中
+            Clear();
+            if (reconnecting)
+            {
+                ++resyncs_;
+                reconnecting = false;
+            }
+
+            while (running_)
+            {
+                // 最多阻塞 1 秒，以便及时响应 Stop
+                conn.await_notification(1, 0);
+
+                if (options_.report_interval.count() > 0 &&
+                    std::chrono::steady_clock::now() - last_report >= options_.report_interval)
+                {
+                    LogStats();
+                    last_report = std::chrono::steady_clock::now();
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+            g_logger->error("缓存失效监听异常: {}，1 秒后重连", e.what());
+            // 监听中断期间无法得知哪些行被修改，重连并重新 LISTEN 之后清空缓存
+            reconnecting = true;
+            for (int i = 0; i < 10 && running_; ++i)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        }
+    }
+}
+
+CacheStats CUserCache::GetStats() const
+{
+    CacheStats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.expired = expired_;
+    stats.evictions = evictions_;
+    stats.invalidations = invalidations_;
+    stats.stale_discarded = stale_discarded_;
+    stats.resyncs = resyncs_;
+    for (const auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.entries += shard->lru.size();
+        stats.bytes += shard->bytes;
+    }
+    return stats;
+}
+
+void CUserCache::LogStats() const
+{
+    CacheStats stats = GetStats();
+    g_logger->info("用户缓存统计 - 命中率: {:.2f}%, 命中: {}, 未命中: {}, 过期: {}, 淘汰: {}, "
+                   "失效通知: {}, 丢弃过时加载: {}, 重建监听: {}, 缓存项: {}, 内存: {} KB",
+                   stats.HitRate() * 100.0, stats.hits, stats.misses, stats.expired, stats.evictions,
+                   stats.invalidations, stats.stale_discarded, stats.resyncs, stats.entries,
+                   stats.bytes / 1024);
+}
+
+void CUserCache::InstallTrigger(pqxx::connection &conn, const std::string &channel)
+{
+    pqxx::work tx(conn);
+    tx.exec("CREATE OR REPLACE FUNCTION users_notify_change() RETURNS trigger AS $$ "
+            "BEGIN "
+            "PERFORM pg_notify(" + tx.quote(channel) + ", OLD.id::text); "
+            "RETURN NULL; "
+            "END; $$ LANGUAGE plpgsql");
+    tx.exec("DROP TRIGGER IF EXISTS users_notify_change ON users");
+    tx.exec("CREATE TRIGGER users_notify_change AFTER UPDATE OR DELETE ON users "
+            "FOR EACH ROW EXECUTE FUNCTION users_notify_change()");
+    tx.commit();
+}
@@ -0,0 +1,105 @@
+#include "CUserDao.h"
+
+#include <charconv>
+#include <string>
+
+#include "CParamArena.h"
+#include "CQueryMetrics.h"
+#include "CStatementRegistry.h"
+
+namespace
+{
+// 语句名只转换一次，避免每次调用由 const char * 构造 std::string
+const std::string &FindByIdName()
+{
+    static const std::string name = CUserDao::STMT_FIND_BY_ID;
+    return name;
+}
+
+const std::string &FindByIdListName()
+{
+    static const std::string name = CUserDao::STMT_FIND_BY_ID_LIST;
+    return name;
+}
+
+// pipeline 批量查询在指标中单独统计（一次调用包含多条语句）
+const std::string &FindByIdsPipelineName()
+{
+    static const std::string name = std::string(CUserDao::STMT_FIND_BY_ID) + ":pipeline";
+    return name;
+}
+} // namespace
+
+void CUserDao::RegisterStatements()
+{
+    auto &registry = CStatementRegistry::GetInstance();
+    registry.Register(STMT_FIND_BY_ID, "SELECT * FROM users WHERE id = $1");
+    registry.Register(STMT_FIND_BY_ID_LIST, "SELECT * FROM users WHERE id = ANY($1::int[])");
+    registry.RegisterTyped<FindUserBrief>();
+}
+
+pqxx::result CUserDao::FindById(CConnectionPool::Handle &handle, int id)
+{
+    CParamArena &arena = CParamArena::ThreadLocal().Reset().Add(id);
+
+    pqxx::nontransaction txn(handle.Conn());
+    return CStatementRegistry::GetInstance().Exec(
+        txn, handle.GetEntry(), FindByIdName(), arena.BuildParams());
+}
+
+std::vector<pqxx::result> CUserDao::FindByIds(CConnectionPool::Handle &handle,
+                                              const std::vector<int> &ids)
+{
+    if (ids.empty())
+        return {};
+
+    // pipeline 只接受 SQL 文本；通过 EXECUTE 复用已准备的语句，仍然省去解析和计划
+    CStatementRegistry::GetInstance().Ensure(handle.GetEntry(), FindByIdName());
+
+    return CQueryMetrics::GetInstance().Measure(FindByIdsPipelineName(), [&]
+    {
+        pqxx::nontransaction txn(handle.Conn());
+        pqxx::pipeline pipe(txn);
+        pipe.retain(static_cast<int>(ids.size())); // 全部插入后再一次性发送
+
+        std::vector<pqxx::pipeline::query_id> query_ids;
+        query_ids.reserve(ids.size());
+        // 复用同一个缓冲区拼接 EXECUTE find_user_by_id(<id>)
+        std::string query = std::string("EXECUTE ") + STMT_FIND_BY_ID + "(";
+        const size_t prefix_len = query.size();
+        char digits[16];
+        for (int id : ids)
+        {
+            auto result = std::to_chars(digits, digits + sizeof(digits), id);
+            query.resize(prefix_len);
+            query.append(digits, result.ptr).push_back(')');
+            query_ids.push_back(pipe.insert(query));
+        }
+        pipe.complete();
+
+        // 按插入顺序取回结果
+        std::vector<pqxx::result> results;
+        results.reserve(ids.size());
+        for (auto query_id : query_ids)
+        {
+            results.push_back(pipe.retrieve(query_id));
+        }
+        return results;
+    });
+}
+
+pqxx::result CUserDao::FindByIdList(CConnectionPool::Handle &handle, const std::vector<int> &ids)
+{
+    // 以数组字面量 {1,2,3} 作为单个参数传递，直接在线程的参数缓冲区中拼接
+    CParamArena &arena = CParamArena::ThreadLocal().Reset().AddArray(ids);
+
+    pqxx::nontransaction txn(handle.Conn());
+    return CStatementRegistry::GetInstance().Exec(
+        txn, handle.GetEntry(), FindByIdListName(), arena.BuildParams());
+}
+
+FindUserBrief::Result CUserDao::FindBriefById(CConnectionPool::Handle &handle, int id)
+{
+    pqxx::nontransaction txn(handle.Conn());
+    return CStatementRegistry::GetInstance().ExecTyped<FindUserBrief>(txn, handle.GetEntry(), id);
+}
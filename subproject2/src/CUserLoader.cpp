@@ -0,0 +1,117 @@
+#include "CUserLoader.h"
+
+#include <algorithm>
+
+#include "CUserDao.h"
+
+CUserLoader::CUserLoader(CRoutedPool &pool, std::chrono::microseconds window, size_t max_batch)
+    : pool_(pool), window_(window), max_batch_(max_batch > 0 ? max_batch : 1)
+{
+}
+
+std::optional<pqxx::row> CUserLoader::Load(int id)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++stats_.loads;
+
+    // 1、加入正在收集的批次，没有则新建批次并成为领导者
+    bool leader = false;
+    if (!current_)
+    {
+        current_ = std::make_shared<Batch>();
+        leader = true;
+    }
+    std::shared_ptr<Batch> batch = current_;
+    CBatchController *controller = controller_;
+    const size_t max_batch = controller ? controller->BatchSize() : max_batch_;
+    if (std::find(batch->keys.begin(), batch->keys.end(), id) == batch->keys.end())
+    {
+        batch->keys.push_back(id);
+    }
+
+    // 凑满 max_batch 个 id 时立即封闭批次，唤醒领导者提前执行
+    if (batch->keys.size() >= max_batch)
+    {
+        batch->sealed = true;
+        current_.reset();
+        batch->cv.notify_all();
+    }
+
+    if (leader)
+    {
+        // 2、领导者等待时间窗口结束或批次被封闭，然后执行查询
+        batch->cv.wait_for(lock, controller ? controller->FlushInterval() : window_, [&batch]
+                           { return batch->sealed; });
+        if (!batch->sealed)
+        {
+            batch->sealed = true;
+            current_.reset();
+        }
+        ++stats_.batches;
+        stats_.keys += batch->keys.size();
+
+        lock.unlock();
+        Execute(*batch, controller); // 批次已封闭，keys 不会再被修改
+        lock.lock();
+
+        batch->done = true;
+        batch->cv.notify_all();
+    }
+    else
+    {
+        // 3、跟随者等待领导者完成查询
+        batch->cv.wait(lock, [&batch]
+                       { return batch->done; });
+    }
+
+    if (batch->error)
+    {
+        std::rethrow_exception(batch->error);
+    }
+    auto it = batch->rows.find(id);
+    if (it == batch->rows.end())
+        return std::nullopt;
+    return it->second;
+}
+
+void CUserLoader::Execute(Batch &batch, CBatchController *controller)
+{
+    try
+    {
+        CConnectionPool::Handle handle = pool_.AcquireFor<pqxx::nontransaction>();
+        auto start = std::chrono::steady_clock::now();
+        pqxx::result result = CUserDao::FindByIdList(handle, batch.keys);
+        if (controller)
+            controller->Observe(batch.keys.size(), std::chrono::steady_clock::now() - start);
+
+        // 按 id 列把结果行分发到各个 key
+        const auto id_column = result.column_number("id");
+        std::unordered_map<int, pqxx::row> rows;
+        for (const auto &row : result)
+        {
+            rows.emplace(row[id_column].as<int>(), row);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        batch.rows = std::move(rows);
+    }
+    catch (...)
+    {
+        if (controller)
+            controller->ObserveError();
+        std::lock_guard<std::mutex> lock(mutex_);
+        batch.error = std::current_exception();
+    }
+}
+
+LoaderStats CUserLoader::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void CUserLoader::SetController(CBatchController *controller)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    controller_ = controller;
+}
@@ -5,6 +5,8 @@
 #include <vector>   // 动态数组容器，存储线程对象
 #include <thread>   // C++11线程库，创建和管理线程
 #include <chrono>   // 时间库，处理时间间隔
+#include <atomic>   // 原子变量，信号处理函数与线程间共享退出标志
+#include <algorithm> // std::max、std::remove
 #include <unistd.h> // Unix标准头文件，提供fork、getpid等系统调用
 #include <signal.h> // 信号处理库，用于处理SIGINT和SIGTERM
 #include <fcntl.h>  // 文件控制，提供open函数和O_RDWR等标志
@@ -18,34 +20,49 @@
 #include <sys/stat.h>  // 添加这个头文件
 
 #include "CConfig.h" // 你的配置管理类
-
-bool bExit = false;
+#include "CCursorScan.h" // 服务端游标分块扫描
+#include "CConnectionPool.h" // 数据库连接池
+#include "CRoutedPool.h"     // 主库/只读副本读写路由
+#include "CStatementRegistry.h" // 预处理语句注册表
+#include "CUserDao.h"            // users 表数据访问
+#include "CAsyncQueryEngine.h"   // epoll 异步查询引擎
+#include "CUserLoader.h"         // 单键查询请求合并
+#include "CUserCache.h"          // 用户行缓存
+#include "CParallelScan.h"       // 按范围分区的并行扫描
+#include "CTaskDispatcher.h"     // LISTEN/NOTIFY 任务分发
+#include "CQueryMetrics.h"       // 按语句统计的延迟直方图
+#include "CQueryWatchdog.h"      // 查询截止时间与退出时取消
+#include "CHedgedReader.h"       // 跨副本的对冲读请求
+#include "CEventSink.h"          // 异步写入事件表
+
+std::atomic<bool> bExit{false};      // 信号处理函数中写入，其他线程读取
+std::atomic<int> g_exitSignal{0};    // 收到的退出信号，由 logExitSignal 在信号处理函数之外记录
 
 // 全局日志记录器
 std::shared_ptr<spdlog::logger> g_logger;
 
-// 信号处理函数
+// 信号处理函数：只设置退出标志。日志会经过文件 sink 和事件 sink（加锁、分配内存、可能阻塞），
+// 都不是异步信号安全的，改由 logExitSignal 在普通线程中记录
 void signalHandler(int signum)
 {
+    g_exitSignal.store(signum);
+    bExit.store(true);
+}
+
+// 记录收到的退出信号（只记录一次），在观察到 bExit 之后调用
+void logExitSignal()
+{
+    int signum = g_exitSignal.exchange(0);
     if (signum == SIGINT)
     {
-        if (g_logger)
-        {
-            g_logger->warn("收到 SIGINT 信号 (Ctrl+C)，准备退出...");
-        }
+        g_logger->warn("收到 SIGINT 信号 (Ctrl+C)，准备退出...");
         std::cout << "\n收到 SIGINT 信号，程序即将退出..." << std::endl;
     }
     else if (signum == SIGTERM)
     {
-        if (g_logger)
-        {
-            g_logger->warn("收到 SIGTERM 信号 (kill命令)，准备退出...");
-        }
+        g_logger->warn("收到 SIGTERM 信号 (kill命令)，准备退出...");
         std::cout << "\n收到 SIGTERM 信号，程序即将退出..." << std::endl;
     }
-    
-    bExit = true;
-
 }
 
 // 辅助函数：日志级别字符串转换为spdlog级别
@@ -218,41 +235,127 @@ void becomeDaemon()
     g_logger->info("工作目录: {}", std::filesystem::current_path().string());
 }
 
-// 循环创建线程的线程任务
-void threadTask(int id)
+// 任务分发器的工作线程任务：每收到一条通知执行一次，没有任务时线程不会被唤醒
+void threadTask(int id, const std::string &payload)
 {
     // 获取当前线程ID的字符串
-    std::string thread_id_str = get_thread_id_str();
+    thread_local std::string thread_id_str = get_thread_id_str();
+    thread_local int loop_count = 0;
+
+    g_logger->info("线程 {} 正在运行执行第 {} 次任务 (payload: '{}', PID: {}, TID: {})",
+                   id, ++loop_count, payload, getpid(), thread_id_str);
+}
 
-    // 记录线程开始（只在日志中记录，不在控制台输出）
-    g_logger->info("线程 {} 开始执行 (PID: {}, TID: {})",
-                   id, getpid(), thread_id_str);
+// 任务分发示例：工作线程等待 NOTIFY 分发的任务，直到收到退出信号
+void dispatchTask(const std::string &conn_str, const std::string &channel, int worker_count)
+{
+    DispatcherOptions options;
+    options.conn_str = conn_str;
+    options.channel = channel;
+    options.workers = worker_count;
+    options.stop_when = []
+    { return bExit.load(); };
 
-    int loop_count = 0;
-    while(!bExit)
+    try
     {
-        g_logger->info("线程 {} 正在运行执行第 {} 次任务 (PID: {}, TID: {})",
-                   id, ++loop_count, getpid(), thread_id_str);
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        CTaskDispatcher dispatcher(options, threadTask);
+        dispatcher.Start();
+        g_logger->info("等待任务通知 (NOTIFY {}, '<payload>')，收到退出信号后停止", channel);
+        dispatcher.Wait();
+        logExitSignal();
+        dispatcher.Stop();
+
+        DispatcherStats stats = dispatcher.GetStats();
+        g_logger->info("任务分发统计 - 通知: {}, 完成: {}, 失败: {}, 重连: {}, 取任务延迟 p50: {:.3f} ms, "
+                       "p99: {:.3f} ms, 最大: {:.3f} ms",
+                       stats.notifications, stats.completed, stats.failed, stats.reconnects,
+                       stats.pickup_p50_ms, stats.pickup_p99_ms, stats.pickup_max_ms);
+    }
+    catch (const std::exception &e)
+    {
+        g_logger->error("任务分发器异常: {}", e.what());
     }
-
-    g_logger->info("线程 {} 正在运行执行完毕", id);    
-
-    // 打印线程执行信息
-    std::cout << "线程 " << id << " 执行完毕 (PID: " << getpid() << ", TID: " << thread_id_str << ")" << std::endl;
 }
 
-// 数据库线程任务：在独立连接中执行简单的读写操作
-void dbThreadTask(const std::string &conn_str, int id)
+// 数据库线程共享的组件
+struct DbContext
+{
+    CRoutedPool &pool;             // 读请求路由到副本，写请求路由到主库
+    CUserLoader *loader = nullptr; // 单键查询请求合并（未启用时为空）
+    CUserCache *cache = nullptr;   // 用户行缓存（未启用时为空）
+    std::chrono::milliseconds query_timeout{0}; // 单次请求的截止时间（0 表示不限，退出时仍会被取消）
+    CHedgedReader *hedger = nullptr; // 对冲读请求（未启用时为空）
+    CEventSink *events = nullptr;    // 业务事件写入（未启用时为空）
+};
+
+// 数据库线程任务：从连接池借出连接执行简单的读写操作
+void dbThreadTask(DbContext &ctx, int id)
 {
     std::string thread_id_str = get_thread_id_str();
     g_logger->info("数据库线程 {} 启动 (TID: {})", id, thread_id_str);
 
+    CRoutedPool &pool = ctx.pool;
+
     try
     {
-        pqxx::connection conn(conn_str);
+        // 缓存查询：命中时不访问数据库，未命中时从连接池借出连接加载
+        // （与合并查询一样，必须在本线程借出连接之前调用）
+        if (ctx.cache)
+        {
+            int user_id = id % 5 + 1;
+            std::optional<UserRecord> user = ctx.cache->Get(user_id);
+            if (user)
+            {
+                g_logger->info("缓存查询 - id: {}, username: {}", user->id, user->username);
+            }
+            else
+            {
+                g_logger->info("缓存查询 - id {} 不存在", user_id);
+            }
+        }
+
+        // 合并查询：并发线程同时请求的 id 合并为一条 ANY($1) 查询
+        // （必须在借出连接之前调用，合并查询本身也需要从连接池借出连接）
+        if (ctx.loader)
+        {
+            int user_id = id % 5 + 1;
+            std::optional<pqxx::row> row = ctx.loader->Load(user_id);
+            if (row)
+            {
+                User user = CRowMapper<User>(*row).Map(*row);
+                g_logger->info("合并查询 - id: {}, username: {}", user.id, user.username);
+            }
+            else
+            {
+                g_logger->info("合并查询 - id {} 不存在", user_id);
+            }
+        }
+
+        // 对冲读：首发副本超过对冲延迟未返回时再发往另一个副本，先返回者胜出
+        // （同样必须在借出连接之前调用；落后的一路可能晚于本函数返回，按值捕获参数）
+        if (ctx.hedger)
+        {
+            int user_id = id % 5 + 1;
+            pqxx::result result = ctx.hedger->Run(CUserDao::STMT_FIND_BY_ID, [user_id](CConnectionPool::Handle &h)
+                                                  { return CUserDao::FindById(h, user_id); });
+            if (!result.empty())
+            {
+                User user = CRowMapper<User>(result)[0];
+                g_logger->info("对冲查询 - id: {}, username: {}", user.id, user.username);
+            }
+            else
+            {
+                g_logger->info("对冲查询 - id {} 不存在", user_id);
+            }
+        }
+
+        // 借出连接，handle 析构时自动归还连接池
+        // 以下只有只读查询（nontransaction），路由到只读副本
+        CConnectionPool::Handle handle = pool.AcquireFor<pqxx::nontransaction>();
+        pqxx::connection &conn = handle.Conn();
         if (!conn.is_open())
         {
+            handle.Invalidate();
             g_logger->error("数据库连接未打开");
             return;
         }else
@@ -260,31 +363,24 @@ void dbThreadTask(const std::string &conn_str, int id)
             g_logger->info("数据库连接成功 (数据库: {})", conn.dbname());
         }
 
+        // 本次请求的截止时间：超时或程序退出时取消在途查询，须在开启事务之前建立
+        CQueryWatchdog::Scope deadline(handle, ctx.query_timeout);
+
         // 执行查询操作
         {
             // 示例查询：按 user_id 获取用户信息（避免与函数参数 id 冲突）
             int user_id = 1; 
-            const std::string sql = "SELECT * FROM users WHERE id = $1;";
-            pqxx::nontransaction txn(conn);
-            pqxx::result result = txn.exec_params(sql, user_id);
+            pqxx::result result = CUserDao::FindById(handle, user_id);
 
             if (!result.empty())
             {
-                const auto &r = result[0];
                 try {
-                    int rid = r["id"].as<int>();
-                    std::string username = r["username"].as<std::string>();
-                    std::string full_name = r["full_name"].as<std::string>();
-                    std::string email = r["email"].as<std::string>();
-                    std::string phone = r["phone"].as<std::string>();
-
-                    // std::cout << "id = " << rid << std::endl;
-                    // std::cout << "username = " << username << std::endl;
-                    // std::cout << "full_name = " << full_name << std::endl;
-                    // std::cout << "email = " << email << std::endl;
-                    // std::cout << "phone = " << phone << std::endl;
+                    // 列序号只绑定一次，字符串字段直接引用 result 缓冲区
+                    CRowMapper<User> mapper(result);
+                    User user = mapper[0];
+
                     g_logger->info("查询结果 - id: {}, username: {}, full_name: {}, email: {}, phone: {}",
-                                   rid, username, full_name, email, phone);
+                                   user.id, user.username, user.full_name, user.email, user.phone);
                 }
                 catch (const std::exception &e)
                 {
@@ -299,18 +395,165 @@ void dbThreadTask(const std::string &conn_str, int id)
 
         }
 
+        // 类型化查询：参数和结果列类型在编译期确定，按列序号转换，不再逐个 as<T>()
+        {
+            FindUserBrief::Result brief = CUserDao::FindBriefById(handle, 1);
+            brief.ForEach([](int user_id, std::string_view username, std::string_view email)
+                          { g_logger->info("类型化查询 - id: {}, username: {}, email: {}", user_id, username, email); });
+        }
+
+        // 批量查询操作：多个 id 经 pipeline 一次发送，按顺序取回结果
+        {
+            std::vector<int> user_ids = {1, 2, 3, 4, 5};
+            std::vector<pqxx::result> results = CUserDao::FindByIds(handle, user_ids);
+            for (size_t i = 0; i < results.size(); ++i)
+            {
+                if (results[i].empty())
+                {
+                    g_logger->info("批量查询 - id {} 不存在", user_ids[i]);
+                }
+                else
+                {
+                    User user = CRowMapper<User>(results[i])[0];
+                    g_logger->info("批量查询 - id: {}, username: {}", user.id, user.username);
+                }
+            }
+        }
+
         // 执行更新操作
         
 
+    }
+    catch (const pqxx::query_canceled &e)
+    {
+        g_logger->warn("数据库线程 {} 查询超时或被取消: {}", id, e.what());
     }
     catch (const std::exception &e)
     {
         g_logger->error("数据库线程异常: {}", e.what());
     }
 
+    // 业务事件：只放入队列，由事件写入线程批量 COPY 到事件表，不阻塞本线程（BLOCK 策略且队列满时除外）
+    if (ctx.events)
+    {
+        ctx.events->Emit("db_thread_done", "thread " + std::to_string(id) + " (TID: " + thread_id_str + ")",
+                         "info", "dbThreadTask");
+    }
+
     g_logger->info("数据库线程 {} 结束", id);
 }
 
+// 游标扫描示例：按 fetch_size 分块读取 users 全表，客户端内存只与块大小有关
+void cursorScanTask(CRoutedPool &pool, size_t fetch_size, bool prefetch)
+{
+    g_logger->info("游标扫描开始 - fetch_size: {}, 预取: {}", fetch_size, prefetch);
+
+    try
+    {
+        CConnectionPool::Handle handle = pool.AcquireFor<pqxx::read_transaction>();
+        pqxx::read_transaction txn(handle.Conn());
+
+        size_t chunks = 0;
+        size_t bytes = 0;
+        auto start = std::chrono::steady_clock::now();
+        size_t rows = CursorScan(
+            txn, "SELECT * FROM users ORDER BY id", fetch_size,
+            [&chunks, &bytes](const pqxx::result &chunk)
+            {
+                ++chunks;
+                bytes += CQueryMetrics::ResultBytes(chunk);
+                CRowMapper<User> mapper(chunk);
+                mapper.ForEach([](const User &user)
+                               { g_logger->debug("游标扫描 - id: {}, username: {}", user.id, user.username); });
+            },
+            prefetch);
+        txn.commit();
+        CQueryMetrics::GetInstance().Record("cursor_scan:users", std::chrono::steady_clock::now() - start,
+                                            rows, bytes);
+
+        g_logger->info("游标扫描完成 - 行数: {}, 块数: {}", rows, chunks);
+    }
+    catch (const std::exception &e)
+    {
+        g_logger->error("游标扫描异常: {}", e.what());
+    }
+}
+
+// 并行扫描示例：按主键或 ctid 范围把表分成多段，各段在独立连接上同时读取
+void parallelScanTask(CConnectionPool &pool, const ParallelScanOptions &options)
+{
+    g_logger->info("并行扫描开始 - 表: {}, 分区数: {}, 分区方式: {}, 共享快照: {}", options.table,
+                   options.partitions, options.partitioning == ScanPartitioning::KEY ? "key" : "ctid",
+                   options.consistent_snapshot);
+
+    try
+    {
+        CParallelScan scan(pool, options);
+        uint64_t bytes = 0;
+        ParallelScanStats stats = scan.Run([&bytes](const ScanChunk &chunk)
+                                           { bytes += CQueryMetrics::ResultBytes(chunk.rows); });
+
+        g_logger->info("并行扫描完成 - 行数: {}, 块数: {}, 耗时: {:.3f} s, 行/秒: {:.1f}, KB/秒: {:.1f}",
+                       stats.rows, stats.chunks, stats.seconds,
+                       stats.seconds > 0 ? stats.rows / stats.seconds : 0.0,
+                       stats.seconds > 0 ? bytes / 1024.0 / stats.seconds : 0.0);
+        for (size_t i = 0; i < stats.partition_rows.size(); ++i)
+        {
+            g_logger->info("并行扫描 - 分区 {}: {} 行", i, stats.partition_rows[i]);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        g_logger->error("并行扫描异常: {}", e.what());
+    }
+}
+
+// 异步查询示例：单个事件循环线程驱动多个连接，同时保持多个查询在途
+void asyncQueryTask(const std::string &conn_str, int connection_count, int query_count)
+{
+    g_logger->info("异步查询引擎启动 - 连接数: {}, 查询数: {}", connection_count, query_count);
+
+    try
+    {
+        CAsyncQueryEngine engine(conn_str, connection_count);
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::future<CPgResult>> futures;
+        futures.reserve(query_count);
+        for (int i = 0; i < query_count; ++i)
+        {
+            int user_id = i % 5 + 1;
+            futures.push_back(engine.Submit("SELECT * FROM users WHERE id = $1",
+                                            {std::to_string(user_id)}));
+        }
+
+        int rows = 0;
+        int failed = 0;
+        for (auto &future : futures)
+        {
+            try
+            {
+                rows += future.get().Rows();
+            }
+            catch (const std::exception &e)
+            {
+                ++failed;
+                g_logger->warn("异步查询失败: {}", e.what());
+            }
+        }
+
+        double elapsed_ms = std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+        g_logger->info("异步查询完成 - 查询数: {}, 失败: {}, 返回行数: {}, 耗时: {:.3f} ms",
+                       query_count, failed, rows, elapsed_ms);
+    }
+    catch (const std::exception &e)
+    {
+        g_logger->error("异步查询引擎异常: {}", e.what());
+    }
+}
+
 int main()
 {
     // 读取配置
@@ -367,11 +610,10 @@ int main()
         becomeDaemon();
     }
 
-    // 创建并运行单个线程
-    std::cout << "开始创建单个线程..." << std::endl;
-    g_logger->info("开始创建单个线程");
+    // 创建并运行数据库线程
+    std::cout << "开始创建 " << threadCount << " 个数据库线程..." << std::endl;
+    g_logger->info("开始创建 {} 个数据库线程", threadCount);
 
-    // 直接创建单个线程
     if (!dbname.empty())
     {
         // 构建连接字符串：数据库连接信息
@@ -382,43 +624,365 @@ int main()
                 << " hostaddr=" << hostaddr
                 << " port=" << dbport;
 
-        std::string db_conn_str = conn_ss.str();
+        // 读取连接池配置
+        PoolOptions pool_options;
+        pool_options.conn_str = conn_ss.str();
+        pool_options.min_size = config.GetIntDefault("pool_min_size", 1);
+        pool_options.max_size = config.GetIntDefault("pool_max_size", threadCount);
+        pool_options.idle_timeout = std::chrono::milliseconds(config.GetIntDefault("pool_idle_timeout_ms", 60000));
+        pool_options.checkout_timeout = std::chrono::milliseconds(config.GetIntDefault("pool_checkout_timeout_ms", 5000));
+
+        // 登记预处理语句；配置为建立连接时准备则在 on_connect 中一次性准备全部语句
+        CUserDao::RegisterStatements();
+        if (config.GetBoolDefault("prepare_on_connect", true))
+        {
+            pool_options.on_connect = [](PooledConnection &entry)
+            {
+                CStatementRegistry::GetInstance().PrepareAll(entry);
+            };
+        }
 
         g_logger->info("将使用数据库连接 - dbname: {}, hostaddr: {}, port: {}", dbname, hostaddr, dbport);
+        g_logger->info("连接池配置 - min: {}, max: {}, 空闲超时: {} ms, 借出超时: {} ms",
+                       pool_options.min_size, pool_options.max_size,
+                       pool_options.idle_timeout.count(), pool_options.checkout_timeout.count());
+
+        // 只读副本：每项可单独指定 hostaddr/port/dbname/user/password，未指定的沿用主库配置，
+        // 连接池大小等其余参数与主库相同
+        std::vector<PoolOptions> replica_options;
+        YAML::Node replicas = config.GetNode("replicas");
+        if (replicas && replicas.IsSequence())
+        {
+            for (const auto &replica : replicas)
+            {
+                std::string replica_host = replica["hostaddr"].as<std::string>(hostaddr);
+                int replica_port = replica["port"].as<int>(dbport);
+
+                std::stringstream replica_ss;
+                replica_ss << "dbname=" << replica["dbname"].as<std::string>(dbname)
+                           << " user=" << replica["user"].as<std::string>(dbuser)
+                           << " password='" << replica["password"].as<std::string>(dbpass) << "'"
+                           << " hostaddr=" << replica_host
+                           << " port=" << replica_port;
+
+                PoolOptions options = pool_options;
+                options.conn_str = replica_ss.str();
+                replica_options.push_back(std::move(options));
+                g_logger->info("只读副本 {} - hostaddr: {}, port: {}", replica_options.size(), replica_host, replica_port);
+            }
+        }
+
+        // 业务事件和 warn 及以上的日志异步写入事件表（event_sink_enabled 为 false 时不启用）
+        // 必须在其他后台线程启动之前挂到 g_logger 上：spdlog::logger 的 sink 列表不是线程安全的
+        std::unique_ptr<CEventSink> events;
+        std::shared_ptr<CEventLogSinkMt> event_log_sink;
+        if (config.GetBoolDefault("event_sink_enabled", false))
+        {
+            EventSinkOptions event_options;
+            event_options.conn_str = pool_options.conn_str;
+            event_options.table = config.GetStringDefault("event_table", "app_events");
+            event_options.capacity = static_cast<size_t>(config.GetIntDefault("event_queue_capacity", 10000));
+            event_options.flush_rows = static_cast<size_t>(config.GetIntDefault("event_flush_rows", 500));
+            event_options.flush_interval = std::chrono::milliseconds(config.GetIntDefault("event_flush_interval_ms", 200));
+            event_options.statement_timeout = std::chrono::milliseconds(config.GetIntDefault("event_statement_timeout_ms", 0));
+            std::string overflow = config.GetStringDefault("event_overflow_policy", "block");
+            event_options.policy = overflow == "overrun_oldest" ? OverflowPolicy::OVERRUN_OLDEST
+                                   : overflow == "discard_new"  ? OverflowPolicy::DISCARD_NEW
+                                                                : OverflowPolicy::BLOCK;
+            // 日志记录不允许阻塞：事件库不可用时 BLOCK 会让所有写 warn 日志的线程停住
+            std::string log_overflow = config.GetStringDefault("event_log_overflow_policy", "overrun_oldest");
+            event_options.log_policy = log_overflow == "discard_new" ? OverflowPolicy::DISCARD_NEW
+                                                                     : OverflowPolicy::OVERRUN_OLDEST;
+            try
+            {
+                pqxx::connection conn(event_options.conn_str);
+                CEventSink::CreateTable(conn, event_options.table);
+
+                events = std::make_unique<CEventSink>(event_options);
+
+                // 先挂 sink 再启动写入线程：写入线程的日志同样经过 g_logger，
+                // sink 列表在它启动之后就不能再修改
+                std::string log_level = config.GetStringDefault("event_log_level", "warn");
+                if (log_level != "off")
+                {
+                    event_log_sink = std::make_shared<CEventLogSinkMt>(*events);
+                    event_log_sink->set_level(spdlog::level::from_str(log_level));
+                    g_logger->sinks().push_back(event_log_sink);
+                }
+
+                events->Start();
+                g_logger->info("事件写入已启用 - 表: {}, 队列容量: {}, 溢出策略: {}, 日志溢出策略: {}",
+                               event_options.table, event_options.capacity, overflow,
+                               log_overflow == "discard_new" ? "discard_new" : "overrun_oldest");
+            }
+            catch (const std::exception &e)
+            {
+                if (event_log_sink)
+                {
+                    auto &logger_sinks = g_logger->sinks();
+                    logger_sinks.erase(std::remove(logger_sinks.begin(), logger_sinks.end(), event_log_sink),
+                                       logger_sinks.end());
+                    event_log_sink.reset();
+                }
+                g_logger->error("事件写入初始化失败: {}", e.what());
+                events.reset();
+            }
+        }
+
+        // 按语句统计延迟和吞吐量（metrics_report_interval_s 为 0 时只记录不定期输出）
+        auto &metrics = CQueryMetrics::GetInstance();
+        metrics.SetEnabled(config.GetBoolDefault("metrics_enabled", true));
+        if (metrics.Enabled())
+        {
+            metrics.Start(std::chrono::seconds(config.GetIntDefault("metrics_report_interval_s", 10)));
+        }
+
+        // 查询看门狗：超过截止时间的查询和收到退出信号时已借出连接上的查询由它取消
+        auto &watchdog = CQueryWatchdog::GetInstance();
+        watchdog.Start(&bExit);
+
+        try
+        {
+            // 连接池构造时并行建立 min_size 个连接
+            auto warmup_start = std::chrono::steady_clock::now();
+            CRoutedPool pool(pool_options, replica_options,
+                             std::chrono::milliseconds(config.GetIntDefault("replica_retry_ms", 5000)));
+
+            // 预热：在全部预建连接上并行准备语句目录并执行健康检查，通过后才报告就绪，
+            // 避免重启后的第一批请求承担建连和准备语句的开销
+            if (config.GetBoolDefault("warmup_enabled", true))
+            {
+                int healthy = pool.Warmup([](PooledConnection &entry)
+                {
+                    CStatementRegistry::GetInstance().PrepareAll(entry);
+                    pqxx::nontransaction txn(*entry.conn);
+                    txn.query_value<int>("SELECT 1");
+                });
+                // 以连接池实际使用的 min_size 为准（构造时会按 max_size 截断）
+                const int expected = pool.Primary().GetOptions().min_size;
+                if (healthy < expected)
+                {
+                    throw std::runtime_error("主库连接健康检查未通过 (" + std::to_string(healthy) + "/" +
+                                             std::to_string(expected) + ")");
+                }
+            }
+            double warmup_ms = std::chrono::duration<double, std::milli>(
+                                   std::chrono::steady_clock::now() - warmup_start)
+                                   .count();
+            g_logger->info("========== 服务就绪 (连接预热耗时 {:.3f} ms) ==========", warmup_ms);
+            std::cout << "服务就绪" << std::endl;
+
+            // 单键查询请求合并（coalesce_window_us 为 0 时不启用）
+            // coalesce_adaptive 为 true 时由控制器按每批耗时调整窗口和批大小（控制器须比 loader 存活更久）
+            std::unique_ptr<CBatchController> loader_controller;
+            std::unique_ptr<CUserLoader> loader;
+            int coalesce_window_us = config.GetIntDefault("coalesce_window_us", 0);
+            if (coalesce_window_us > 0)
+            {
+                const size_t coalesce_max_batch = static_cast<size_t>(config.GetIntDefault("coalesce_max_batch", 64));
+                loader = std::make_unique<CUserLoader>(
+                    pool, std::chrono::microseconds(coalesce_window_us), coalesce_max_batch);
+
+                if (config.GetBoolDefault("coalesce_adaptive", false))
+                {
+                    BatchControlOptions control;
+                    control.initial_size = coalesce_max_batch;
+                    control.min_size = 1;
+                    control.max_size = static_cast<size_t>(config.GetIntDefault("coalesce_adaptive_max_batch", 1024));
+                    control.increase_step = std::max<size_t>(1, coalesce_max_batch / 8);
+                    control.target_latency = std::chrono::milliseconds(config.GetIntDefault("coalesce_target_latency_ms", 5));
+                    control.min_interval = std::chrono::microseconds(50);
+                    control.max_interval = std::chrono::microseconds(coalesce_window_us);
+                    loader_controller = std::make_unique<CBatchController>(control);
+                    loader->SetController(loader_controller.get());
+
+                    // 当前批大小和窗口随语句统计一起定期输出，便于画出随负载变化的曲线
+                    CBatchController *controller = loader_controller.get();
+                    metrics.SetGauge("loader:batch_size", [controller]
+                                     { return double(controller->BatchSize()); });
+                    metrics.SetGauge("loader:window_us", [controller]
+                                     { return double(controller->FlushInterval().count()); });
+                }
+            }
+
+            // 用户行缓存（cache_enabled 为 false 时不启用）
+            std::unique_ptr<CUserCache> cache;
+            if (config.GetBoolDefault("cache_enabled", false))
+            {
+                CacheOptions cache_options;
+                cache_options.conn_str = pool_options.conn_str;
+                cache_options.channel = config.GetStringDefault("cache_channel", "users_changed");
+                cache_options.shard_count = static_cast<size_t>(config.GetIntDefault("cache_shards", 16));
+                cache_options.memory_budget = static_cast<size_t>(config.GetIntDefault("cache_memory_mb", 64)) * 1024 * 1024;
+                cache_options.ttl = std::chrono::milliseconds(config.GetIntDefault("cache_ttl_ms", 60000));
+                cache_options.report_interval = std::chrono::seconds(config.GetIntDefault("cache_report_interval_s", 60));
+
+                if (config.GetBoolDefault("cache_install_trigger", false))
+                {
+                    CConnectionPool::Handle handle = pool.AcquireFor<pqxx::work>();
+                    CUserCache::InstallTrigger(handle.Conn(), cache_options.channel);
+                    g_logger->info("已安装 users 变更通知触发器 (通道: {})", cache_options.channel);
+                }
+
+                // 缓存从主库加载：失效通知来自主库，从有复制延迟的副本加载可能把旧值重新写入缓存
+                cache = std::make_unique<CUserCache>(cache_options, [&pool](int user_id) -> std::optional<UserRecord>
+                {
+                    CConnectionPool::Handle handle = pool.Acquire(Route::PRIMARY);
+                    pqxx::result result = CUserDao::FindById(handle, user_id);
+                    if (result.empty())
+                        return std::nullopt;
+                    return UserRecord(CRowMapper<User>(result)[0]);
+                });
+                cache->Start();
+            }
+
+            const std::chrono::milliseconds query_timeout(config.GetIntDefault("query_timeout_ms", 0));
+
+            // 对冲读请求（hedge_enabled 为 false 时不启用）
+            std::unique_ptr<CHedgedReader> hedger;
+            if (config.GetBoolDefault("hedge_enabled", false))
+            {
+                HedgeOptions hedge_options;
+                hedge_options.percentile = config.GetDoubleDefault("hedge_percentile", 0.95);
+                hedge_options.min_delay = std::chrono::milliseconds(config.GetIntDefault("hedge_min_delay_ms", 1));
+                hedge_options.max_delay = std::chrono::milliseconds(config.GetIntDefault("hedge_max_delay_ms", 1000));
+                hedge_options.window = static_cast<uint64_t>(config.GetIntDefault("hedge_window", 200));
+                hedge_options.timeout = query_timeout;
+                hedge_options.workers = static_cast<size_t>(config.GetIntDefault("hedge_workers", threadCount * 2));
+                hedger = std::make_unique<CHedgedReader>(pool, hedge_options);
+            }
+
+            DbContext ctx{pool, loader.get(), cache.get(), query_timeout, hedger.get(), events.get()};
+
+            // thread_count 个数据库线程共享同一个连接池
+            std::vector<std::thread> db_threads;
+            db_threads.reserve(threadCount);
+            for (int i = 0; i < threadCount; ++i)
+            {
+                db_threads.emplace_back(dbThreadTask, std::ref(ctx), i);
+            }
+            for (auto &db_thread : db_threads)
+            {
+                if (db_thread.joinable())
+                    db_thread.join();
+            }
+
+            if (loader)
+            {
+                LoaderStats loader_stats = loader->GetStats();
+                g_logger->info("请求合并统计 - 调用次数: {}, 查询次数: {}, 查询 id 数: {}",
+                               loader_stats.loads, loader_stats.batches, loader_stats.keys);
+            }
+            if (loader_controller)
+            {
+                BatchControlStats control_stats = loader_controller->GetStats();
+                g_logger->info("自适应批大小 [loader] - 当前批大小: {}, 窗口: {:.3f} ms, 批次: {}, 增大: {}, 减小: {}, "
+                               "平均耗时: {:.3f} ms",
+                               control_stats.batch_size, control_stats.flush_interval_ms, control_stats.batches,
+                               control_stats.increases, control_stats.decreases, control_stats.avg_latency_ms);
+            }
 
-        // 创建单个数据库线程并直接 join，id 为 0
-        std::thread db_thread(dbThreadTask, db_conn_str, 0);
-        if (db_thread.joinable())
-            db_thread.join();
+            if (cache)
+            {
+                cache->LogStats();
+                cache->Stop();
+            }
+
+            if (hedger)
+            {
+                hedger->LogStats();
+                hedger.reset(); // 等待落后的一路结束后再继续使用连接池
+            }
+
+            // 游标分块扫描（fetch_size 为 0 时不启用）
+            int fetch_size = config.GetIntDefault("fetch_size", 0);
+            if (fetch_size > 0)
+            {
+                cursorScanTask(pool, static_cast<size_t>(fetch_size),
+                               config.GetBoolDefault("cursor_prefetch", true));
+            }
+
+            // 并行扫描（parallel_scan_partitions 为 0 时不启用）；有副本时在第一个副本上扫描
+            int scan_partitions = config.GetIntDefault("parallel_scan_partitions", 0);
+            if (scan_partitions > 0)
+            {
+                ParallelScanOptions scan_options;
+                scan_options.table = config.GetStringDefault("parallel_scan_table", "users");
+                scan_options.key_column = config.GetStringDefault("parallel_scan_key", "id");
+                scan_options.partitioning = config.GetStringDefault("parallel_scan_mode", "key") == "ctid"
+                                                ? ScanPartitioning::CTID
+                                                : ScanPartitioning::KEY;
+                scan_options.partitions = scan_partitions;
+                if (fetch_size > 0)
+                    scan_options.fetch_size = static_cast<size_t>(fetch_size);
+                scan_options.consistent_snapshot = config.GetBoolDefault("parallel_scan_snapshot", true);
+                parallelScanTask(pool.ReplicaCount() > 0 ? pool.Replica(0) : pool.Primary(), scan_options);
+            }
+
+            // 异步查询引擎（async_connections 为 0 时不启用）
+            int async_connections = config.GetIntDefault("async_connections", 0);
+            if (async_connections > 0)
+            {
+                asyncQueryTask(pool_options.conn_str, async_connections,
+                               config.GetIntDefault("async_demo_queries", 100));
+            }
+
+            // LISTEN/NOTIFY 任务分发（dispatch_enabled 为 false 时不启用），运行到收到退出信号
+            if (config.GetBoolDefault("dispatch_enabled", false))
+            {
+                dispatchTask(pool_options.conn_str, config.GetStringDefault("dispatch_channel", "task_ready"),
+                             threadCount);
+            }
+
+            // 输出最后一个时间窗口的语句统计
+            if (metrics.Enabled())
+            {
+                metrics.Stop();
+                metrics.Report();
+            }
+            metrics.RemoveGauge("loader:batch_size");
+            metrics.RemoveGauge("loader:window_us");
+
+            // 输出各连接池统计，便于在真实负载下调整池大小和副本数量
+            pool.LogStats();
+
+            WatchdogStats watchdog_stats = watchdog.GetStats();
+            g_logger->info("查询看门狗统计 - 借出次数: {}, 请求数: {}, 超时取消: {}, 退出取消: {}",
+                           watchdog_stats.checkouts, watchdog_stats.scopes, watchdog_stats.deadline_cancels,
+                           watchdog_stats.shutdown_cancels);
+        }
+        catch (const std::exception &e)
+        {
+            g_logger->error("连接池初始化失败: {}", e.what());
+        }
+
+        // 连接池析构之前的全部 Scope 均已结束，此后不再需要看门狗
+        watchdog.Stop();
+
+        // 其他后台线程均已停止：先从 g_logger 摘下事件 sink，再写完剩余事件
+        if (events)
+        {
+            if (event_log_sink)
+            {
+                auto &logger_sinks = g_logger->sinks();
+                logger_sinks.erase(std::remove(logger_sinks.begin(), logger_sinks.end(), event_log_sink),
+                                   logger_sinks.end());
+            }
+            events->Stop();
+            EventSinkStats event_stats = events->GetStats();
+            g_logger->info("事件写入统计 - 提交: {}, 写入: {}, 丢弃新记录: {}, 覆盖旧记录: {}, 退出时丢弃: {}, "
+                           "COPY 次数: {}, 失败: {}",
+                           event_stats.emitted, event_stats.written, event_stats.discarded, event_stats.overrun,
+                           event_stats.dropped, event_stats.flushes, event_stats.failures);
+        }
     }
     else
     {
         g_logger->warn("数据库连接信息不完整，跳过数据库线程创建");
     }
 
-    // // 步骤3：创建并运行线程
-    // std::cout << "开始创建 " << threadCount << " 个线程..." << std::endl;
-
-    // std::vector<std::thread> threads; // 创建线程容器
-    // threads.reserve(threadCount + 1);     // 预分配空间（包括一个数据库线程）
-
-    // // 循环创建指定数量的线程
-    // for (int i = 0; i < threadCount; ++i)
-    // {
-    //     // std::thread(threadTask, i) 创建新线程
-    //     // threadTask: 线程要执行的函数
-    //     // i: 传递给threadTask的参数
-    //     // push_back: 将线程对象添加到vector中
-    //     threads.push_back(std::thread(threadTask, i));
-    // }
-
-    // // 步骤4：等待所有线程完成
-    // for (auto &thread : threads)
-    // {
-    //     thread.join();
-    // }
-
     // 记录和显示最终状态
+    logExitSignal();
     g_logger->info("所有线程执行完毕");
     g_logger->info("========== 应用程序结束 ==========");
 